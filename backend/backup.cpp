@@ -0,0 +1,230 @@
+#include "backup.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <dirent.h>
+#include <iostream>
+#include <sqlite3.h>
+#include <sys/stat.h>
+#include <vector>
+
+namespace {
+
+const char kSnapshotPrefix[] = "recipes-";
+const char kSnapshotSuffix[] = ".db";
+
+// If writers keep restarting the incremental copy, finish in one step.
+// Under WAL that step only holds a read transaction, which doesn't block
+// writers either.
+const int kMaxRestarts = 3;
+
+bool endsWith(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::string timestamp() {
+    std::time_t now = std::time(nullptr);
+    std::tm tm;
+    gmtime_r(&now, &tm);
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y%m%d-%H%M%S", &tm);
+    return buf;
+}
+
+}
+
+BackupManager::BackupManager(const std::string& dbPath, const BackupSettings& settings)
+    : dbPath(dbPath), settings(settings), stopping(false), triggered(false),
+      running(false), pagesDone(0), pagesTotal(0), successes(0), failures(0),
+      lastSuccessUnix(0), lastDurationSeconds(0) {}
+
+BackupManager::~BackupManager() {
+    stop();
+}
+
+void BackupManager::start() {
+    if (worker.joinable()) {
+        return;
+    }
+    if (mkdir(settings.directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "Can't create backup directory " << settings.directory << std::endl;
+    }
+    worker = std::thread(&BackupManager::run, this);
+}
+
+void BackupManager::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void BackupManager::requestBackup() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        triggered = true;
+    }
+    wake.notify_all();
+}
+
+BackupStatus BackupManager::status() const {
+    BackupStatus s;
+    s.running = running;
+    s.pagesDone = pagesDone;
+    s.pagesTotal = pagesTotal;
+    s.successes = successes;
+    s.failures = failures;
+    s.lastSuccessUnix = lastSuccessUnix;
+    s.lastDurationSeconds = lastDurationSeconds;
+    std::lock_guard<std::mutex> lock(resultMutex);
+    s.lastFile = lastFile;
+    s.lastError = lastError;
+    return s;
+}
+
+bool BackupManager::interrupted() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stopping;
+}
+
+void BackupManager::run() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            auto due = [this] { return stopping || triggered; };
+            if (settings.intervalSeconds > 0) {
+                wake.wait_for(lock, std::chrono::seconds(settings.intervalSeconds), due);
+            } else {
+                wake.wait(lock, due);
+            }
+            if (stopping) {
+                return;
+            }
+            triggered = false;
+        }
+
+        if (backupOnce()) {
+            rotate();
+        }
+    }
+}
+
+bool BackupManager::backupOnce() {
+    auto started = std::chrono::steady_clock::now();
+    std::string finalPath = settings.directory + "/" + kSnapshotPrefix + timestamp() + kSnapshotSuffix;
+    std::string tmpPath = finalPath + ".tmp";
+
+    running = true;
+    pagesDone = 0;
+    pagesTotal = 0;
+
+    sqlite3* src = nullptr;
+    sqlite3* dest = nullptr;
+    std::string error;
+
+    if (sqlite3_open_v2(dbPath.c_str(), &src, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        error = std::string("open source: ") + sqlite3_errmsg(src);
+    } else if (sqlite3_open(tmpPath.c_str(), &dest) != SQLITE_OK) {
+        error = std::string("open destination: ") + sqlite3_errmsg(dest);
+    } else {
+        sqlite3_backup* backup = sqlite3_backup_init(dest, "main", src, "main");
+        if (!backup) {
+            error = std::string("init: ") + sqlite3_errmsg(dest);
+        } else {
+            int restarts = 0;
+            int lastRemaining = -1;
+            int rc;
+            do {
+                int pages = restarts >= kMaxRestarts ? -1 : settings.pagesPerStep;
+                rc = sqlite3_backup_step(backup, pages);
+
+                int remaining = sqlite3_backup_remaining(backup);
+                int total = sqlite3_backup_pagecount(backup);
+                // A write from another connection restarts the copy
+                if (lastRemaining >= 0 && remaining > lastRemaining) {
+                    ++restarts;
+                }
+                lastRemaining = remaining;
+                pagesTotal = total;
+                pagesDone = total - remaining;
+
+                if (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+                    if (interrupted()) {
+                        break;
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(settings.stepPauseMs));
+                }
+            } while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+
+            sqlite3_backup_finish(backup);
+            if (rc != SQLITE_DONE) {
+                error = rc == SQLITE_OK ? "interrupted by shutdown"
+                                        : std::string("step: ") + sqlite3_errstr(rc);
+            }
+        }
+    }
+
+    if (dest) {
+        sqlite3_close(dest);
+    }
+    if (src) {
+        sqlite3_close(src);
+    }
+
+    if (error.empty() && std::rename(tmpPath.c_str(), finalPath.c_str()) != 0) {
+        error = "rename failed";
+    }
+    if (!error.empty()) {
+        std::remove(tmpPath.c_str());
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    running = false;
+
+    std::lock_guard<std::mutex> lock(resultMutex);
+    if (!error.empty()) {
+        ++failures;
+        lastError = error;
+        std::cerr << "Backup failed: " << error << std::endl;
+        return false;
+    }
+
+    ++successes;
+    lastSuccessUnix = std::time(nullptr);
+    lastDurationSeconds = seconds;
+    lastFile = finalPath;
+    std::cout << "Backup written to " << finalPath << " in " << seconds << "s" << std::endl;
+    return true;
+}
+
+void BackupManager::rotate() {
+    DIR* dir = opendir(settings.directory.c_str());
+    if (!dir) {
+        return;
+    }
+
+    // Timestamped names sort chronologically
+    std::vector<std::string> snapshots;
+    while (dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.compare(0, sizeof(kSnapshotPrefix) - 1, kSnapshotPrefix) == 0 && endsWith(name, kSnapshotSuffix)) {
+            snapshots.push_back(name);
+        }
+    }
+    closedir(dir);
+
+    std::sort(snapshots.begin(), snapshots.end());
+    size_t keep = settings.keep > 0 ? settings.keep : 1;
+    for (size_t i = 0; i + keep < snapshots.size(); ++i) {
+        std::string path = settings.directory + "/" + snapshots[i];
+        if (std::remove(path.c_str()) != 0) {
+            std::cerr << "Can't remove old backup " << path << std::endl;
+        }
+    }
+}
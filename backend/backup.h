@@ -0,0 +1,76 @@
+#ifndef BACKUP_H
+#define BACKUP_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct BackupSettings {
+    std::string directory = "backups";
+    int intervalSeconds = 3600;  // <= 0 disables scheduled backups
+    int keep = 7;                // snapshots kept after rotation
+    int pagesPerStep = 256;      // pages copied per sqlite3_backup_step
+    int stepPauseMs = 5;         // sleep between steps
+};
+
+struct BackupStatus {
+    bool running;
+    int pagesDone;
+    int pagesTotal;
+    uint64_t successes;
+    uint64_t failures;
+    int64_t lastSuccessUnix;     // 0 if none yet
+    double lastDurationSeconds;
+    std::string lastFile;
+    std::string lastError;
+};
+
+// Takes online snapshots of the live database on a background thread with
+// the SQLite backup API. Pages are copied a few at a time from a separate
+// connection, with a pause between steps, so a backup never holds locks the
+// request path needs for long. Each snapshot is written to a temporary file
+// and renamed into place, then the oldest beyond `keep` are deleted.
+class BackupManager {
+private:
+    std::string dbPath;
+    BackupSettings settings;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping;
+    bool triggered;
+
+    std::atomic<bool> running;
+    std::atomic<int> pagesDone;
+    std::atomic<int> pagesTotal;
+    std::atomic<uint64_t> successes;
+    std::atomic<uint64_t> failures;
+    std::atomic<int64_t> lastSuccessUnix;
+    std::atomic<double> lastDurationSeconds;
+    mutable std::mutex resultMutex;
+    std::string lastFile;
+    std::string lastError;
+
+    void run();
+    bool backupOnce();
+    void rotate();
+    bool interrupted();
+
+public:
+    BackupManager(const std::string& dbPath, const BackupSettings& settings);
+    ~BackupManager();
+    BackupManager(const BackupManager&) = delete;
+    BackupManager& operator=(const BackupManager&) = delete;
+
+    void start();
+    void stop();
+    // Starts a backup now (or right after the one in progress).
+    void requestBackup();
+    BackupStatus status() const;
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+// Minimal timing harness shared by the bench/ programs, so they build
+// without any third-party benchmark library.
+namespace bench
+{
+
+// Keeps the compiler from discarding a value that is computed but unused.
+template <typename T>
+inline void doNotOptimize(const T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Result
+{
+    double nsPerIter;  // median over batches
+    size_t iterations; // total timed calls
+};
+
+// Calls fn() once to warm up, then in batches until minSeconds have passed,
+// and reports the median per-call time across batches.
+template <typename Fn>
+Result run(Fn &&fn, double minSeconds = 0.5)
+{
+    using Clock = std::chrono::steady_clock;
+
+    fn();
+
+    // Size batches so each takes roughly 10ms
+    size_t batch = 1;
+    for (;;)
+    {
+        auto start = Clock::now();
+        for (size_t i = 0; i < batch; ++i)
+            fn();
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        if (ns >= 1e7 || batch >= (size_t(1) << 30))
+            break;
+        batch *= 2;
+    }
+
+    std::vector<double> samples;
+    size_t iterations = 0;
+    auto deadline = Clock::now() + std::chrono::duration<double>(minSeconds);
+    while (samples.size() < 5 || Clock::now() < deadline)
+    {
+        auto start = Clock::now();
+        for (size_t i = 0; i < batch; ++i)
+            fn();
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        samples.push_back(ns / batch);
+        iterations += batch;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    return Result{samples[samples.size() / 2], iterations};
+}
+
+}
+
+#endif
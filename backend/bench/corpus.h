@@ -0,0 +1,75 @@
+#ifndef BENCH_CORPUS_H
+#define BENCH_CORPUS_H
+
+#include "recipe.h"
+#include <random>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+
+// In-memory recipes shaped like real ones: multi-line instructions, long
+// ingredient lists, some non-ASCII text and quotes that need escaping.
+// Deterministic for a given seed.
+inline std::vector<Recipe> makeCorpus(size_t count, unsigned seed = 42)
+{
+    static const char *words[] = {
+        "butter", "flour", "sugar", "crème", "fraîche", "jalapeño", "\"fresh\"",
+        "garlic", "olive", "oil", "spinach", "feta", "tomato", "basil", "salt",
+        "pepper", "simmer", "whisk", "fold", "bake", "until", "golden", "and",
+    };
+    const size_t wordCount = sizeof(words) / sizeof(words[0]);
+
+    std::mt19937 rng(seed);
+    auto text = [&](size_t wordsWanted, const char *separator)
+    {
+        std::string s;
+        for (size_t i = 0; i < wordsWanted; ++i)
+        {
+            if (i > 0)
+                s += separator;
+            s += words[rng() % wordCount];
+        }
+        return s;
+    };
+
+    std::vector<Recipe> recipes;
+    recipes.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::string title = text(2 + rng() % 4, " ");
+        std::string description = text(20 + rng() % 40, " ");
+        std::string image = "/uploads/" + std::to_string(1700000000 + i) + "_photo.jpg";
+        std::string ingredients = text(8 + rng() % 20, ", ");
+        std::string instructions;
+        size_t steps = 4 + rng() % 10;
+        for (size_t step = 1; step <= steps; ++step)
+            instructions += std::to_string(step) + ". " + text(6 + rng() % 14, " ") + "\n";
+        std::string created = "2025-11-0" + std::to_string(1 + i % 9) + " 12:00:00";
+
+        Recipe recipe;
+        recipe.id = static_cast<int>(i + 1);
+        recipe.title = title;
+        recipe.description = description;
+        recipe.image_url = image;
+        recipe.protein = (rng() % 600) / 10.0;
+        recipe.carbs = (rng() % 900) / 10.0;
+        recipe.is_vegan = rng() % 5 == 0;
+        recipe.is_vegetarian = recipe.is_vegan || rng() % 3 == 0;
+        recipe.is_gluten_free = rng() % 4 == 0;
+        recipe.cook_time = 5 + rng() % 180;
+        recipe.difficulty = difficultyFromRank(1 + rng() % 3);
+        recipe.ingredients = ingredients;
+        recipe.instructions = instructions;
+        recipe.created_at = created;
+        recipe.version = 1;
+        recipe.change_seq = recipe.id;
+        recipes.push_back(std::move(recipe));
+    }
+    return recipes;
+}
+
+}
+
+#endif
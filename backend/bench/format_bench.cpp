@@ -0,0 +1,56 @@
+// Compares encode time and output size of the list wire formats
+// (JSON / NDJSON / CBOR) on an in-memory corpus. No server or database needed.
+//
+//   make format_bench && ./bench/format_bench [recipes]
+
+#include "bench.h"
+#include "corpus.h"
+#include "serialize.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+    std::vector<Recipe> corpus = bench::makeCorpus(count);
+
+    struct Format
+    {
+        const char *name;
+        RecipeFormat format;
+    };
+    const Format formats[] = {
+        {"json", RecipeFormat::Json},
+        {"ndjson", RecipeFormat::Ndjson},
+        {"cbor", RecipeFormat::Cbor},
+    };
+
+    std::printf("%zu recipes\n", count);
+    std::printf("%-8s %12s %12s %12s %10s\n", "format", "ms/list", "ns/recipe", "bytes", "MB/s");
+
+    for (const Format &f : formats)
+    {
+        const RecipeSerializer &serializer = serializerFor(f.format);
+        std::string out;
+        auto encode = [&]()
+        {
+            out.clear();
+            serializer.beginList(out);
+            bool first = true;
+            for (const Recipe &recipe : corpus)
+            {
+                serializer.appendItem(out, viewOf(recipe), first);
+                first = false;
+            }
+            serializer.endList(out);
+            bench::doNotOptimize(out.data());
+        };
+
+        bench::Result r = bench::run(encode);
+        std::printf("%-8s %12.3f %12.1f %12zu %10.1f\n", f.name, r.nsPerIter / 1e6,
+                    r.nsPerIter / count, out.size(), out.size() / (r.nsPerIter / 1e3));
+    }
+    return 0;
+}
@@ -0,0 +1,314 @@
+// HTTP load generator for a running recipe_server. Each connection runs in
+// its own thread and issues a weighted mix of requests back to back for a
+// fixed time, then throughput and latency percentiles are reported per
+// request kind.
+//
+//   ./bench/load_bench [--host=127.0.0.1] [--port=8080] [--connections=16]
+//                      [--duration=10] [--warmup=2] [--keep-alive=1]
+//                      [--mix=list:10,filter:30,sort:20,detail:35,create:5]
+//                      [--ids=10000] [--list-limit=50] [--seed=1]
+//
+// `make bench` starts a server on a generated dataset and runs this against it.
+
+#include "httplib.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+enum Kind
+{
+    KindList,   // first page in the default order
+    KindFilter, // macro range and dietary flags
+    KindSort,   // top-K by cook time, difficulty or date
+    KindDetail, // one recipe by id
+    KindCreate, // multipart form POST
+    KindCount
+};
+
+const char *kKindNames[KindCount] = {"list", "filter", "sort", "detail", "create"};
+
+struct Options
+{
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    int connections = 16;
+    double duration = 10;
+    double warmup = 2;
+    bool keepAlive = true;
+    int weights[KindCount] = {10, 30, 20, 35, 5};
+    int ids = 10000;
+    int listLimit = 50;
+    unsigned seed = 1;
+};
+
+struct KindStats
+{
+    std::vector<uint32_t> latencyMicros;
+    uint64_t errors = 0;
+    uint64_t bytes = 0;
+};
+
+bool parseMix(const std::string &spec, int weights[KindCount])
+{
+    std::fill(weights, weights + KindCount, 0);
+    size_t start = 0;
+    while (start < spec.size())
+    {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos)
+            end = spec.size();
+        std::string item = spec.substr(start, end - start);
+        size_t colon = item.find(':');
+        if (colon == std::string::npos)
+            return false;
+        std::string name = item.substr(0, colon);
+        int k = 0;
+        while (k < KindCount && name != kKindNames[k])
+            ++k;
+        if (k == KindCount)
+            return false;
+        weights[k] = std::atoi(item.c_str() + colon + 1);
+        start = end + 1;
+    }
+    int total = 0;
+    for (int k = 0; k < KindCount; ++k)
+        total += weights[k];
+    return total > 0;
+}
+
+bool parseOptions(int argc, char **argv, Options &options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos)
+        {
+            std::fprintf(stderr, "Unexpected argument: %s\n", arg.c_str());
+            return false;
+        }
+        std::string key = arg.substr(2, eq - 2);
+        std::string value = arg.substr(eq + 1);
+        if (key == "host")
+            options.host = value;
+        else if (key == "port")
+            options.port = std::atoi(value.c_str());
+        else if (key == "connections")
+            options.connections = std::max(1, std::atoi(value.c_str()));
+        else if (key == "duration")
+            options.duration = std::atof(value.c_str());
+        else if (key == "warmup")
+            options.warmup = std::atof(value.c_str());
+        else if (key == "keep-alive")
+            options.keepAlive = value != "0";
+        else if (key == "mix")
+        {
+            if (!parseMix(value, options.weights))
+            {
+                std::fprintf(stderr, "Bad --mix, expected e.g. list:10,detail:90\n");
+                return false;
+            }
+        }
+        else if (key == "ids")
+            options.ids = std::max(1, std::atoi(value.c_str()));
+        else if (key == "list-limit")
+            options.listLimit = std::atoi(value.c_str());
+        else if (key == "seed")
+            options.seed = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        else
+        {
+            std::fprintf(stderr, "Unknown option: --%s\n", key.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string filterPath(std::mt19937 &rng)
+{
+    static const char *flags[] = {"vegan", "vegetarian", "glutenFree"};
+    double minProtein = rng() % 50;
+    double minCarbs = rng() % 80;
+    std::string path = "/api/recipes?minProtein=" + std::to_string(minProtein) +
+                       "&maxProtein=" + std::to_string(minProtein + 5) +
+                       "&minCarbs=" + std::to_string(minCarbs) +
+                       "&maxCarbs=" + std::to_string(minCarbs + 20);
+    if (rng() % 2 == 0)
+        path += std::string("&") + flags[rng() % 3] + "=true";
+    return path;
+}
+
+std::string sortPath(std::mt19937 &rng, int limit)
+{
+    static const char *columns[] = {"cook_time", "difficulty", "created_at"};
+    return std::string("/api/recipes?sortBy=") + columns[rng() % 3] +
+           "&order=" + (rng() % 2 ? "asc" : "desc") + "&limit=" + std::to_string(limit > 0 ? limit : 50);
+}
+
+httplib::UploadFormDataItems createForm(std::mt19937 &rng, uint64_t n)
+{
+    auto field = [](const char *name, const std::string &value)
+    { return httplib::UploadFormData{name, value, "", ""}; };
+    return {
+        field("title", "Load test recipe " + std::to_string(n)),
+        field("description", "Created by load_bench to exercise the write path."),
+        field("protein", std::to_string(rng() % 60)),
+        field("carbs", std::to_string(rng() % 90)),
+        field("is_vegan", rng() % 5 == 0 ? "1" : "0"),
+        field("is_vegetarian", rng() % 3 == 0 ? "1" : "0"),
+        field("is_gluten_free", rng() % 4 == 0 ? "1" : "0"),
+        field("cook_time", std::to_string(5 + rng() % 120)),
+        field("difficulty", rng() % 2 ? "easy" : "medium"),
+        field("ingredients", "flour, water, salt, yeast"),
+        field("instructions", "1. Mix\n2. Knead\n3. Bake"),
+    };
+}
+
+void worker(const Options &options, unsigned id, Clock::time_point recordFrom, Clock::time_point stopAt,
+            std::vector<KindStats> &stats)
+{
+    std::mt19937 rng(options.seed * 7919 + id);
+    int totalWeight = 0;
+    for (int k = 0; k < KindCount; ++k)
+        totalWeight += options.weights[k];
+
+    httplib::Client client(options.host, options.port);
+    client.set_keep_alive(options.keepAlive);
+    client.set_tcp_nodelay(true);
+    client.set_read_timeout(30, 0);
+
+    uint64_t sent = 0;
+    while (Clock::now() < stopAt)
+    {
+        int pick = static_cast<int>(rng() % totalWeight);
+        int kind = 0;
+        while (pick >= options.weights[kind])
+            pick -= options.weights[kind++];
+
+        auto start = Clock::now();
+        httplib::Result result;
+        switch (kind)
+        {
+        case KindList:
+            result = client.Get(options.listLimit > 0 ? "/api/recipes?limit=" + std::to_string(options.listLimit)
+                                                      : std::string("/api/recipes"));
+            break;
+        case KindFilter:
+            result = client.Get(filterPath(rng));
+            break;
+        case KindSort:
+            result = client.Get(sortPath(rng, options.listLimit));
+            break;
+        case KindDetail:
+            result = client.Get("/api/recipes/" + std::to_string(1 + rng() % options.ids));
+            break;
+        case KindCreate:
+            result = client.Post("/api/recipes", createForm(rng, (uint64_t(id) << 32) | sent));
+            break;
+        }
+        auto end = Clock::now();
+        ++sent;
+
+        if (start < recordFrom)
+            continue;
+        KindStats &s = stats[kind];
+        if (!result || result->status >= 500)
+        {
+            ++s.errors;
+            continue;
+        }
+        s.bytes += result->body.size();
+        s.latencyMicros.push_back(static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()));
+    }
+}
+
+double percentileMs(const std::vector<uint32_t> &sorted, double q)
+{
+    if (sorted.empty())
+        return 0;
+    size_t rank = static_cast<size_t>(q * sorted.size());
+    return sorted[std::min(rank, sorted.size() - 1)] / 1000.0;
+}
+
+void printRow(const char *name, std::vector<uint32_t> &latencies, uint64_t errors, uint64_t bytes, double seconds)
+{
+    std::sort(latencies.begin(), latencies.end());
+    std::printf("%-8s %10zu %8llu %10.1f %9.1f %9.3f %9.3f %9.3f %9.3f\n", name, latencies.size(),
+                static_cast<unsigned long long>(errors), latencies.size() / seconds, bytes / seconds / 1e6,
+                percentileMs(latencies, 0.5), percentileMs(latencies, 0.99), percentileMs(latencies, 0.999),
+                latencies.empty() ? 0.0 : latencies.back() / 1000.0);
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+        return 2;
+
+    // Give a server that was just started a few seconds to come up
+    httplib::Client probe(options.host, options.port);
+    int attempts = 0;
+    while (!probe.Get("/api/recipes/1"))
+    {
+        if (++attempts == 50)
+        {
+            std::fprintf(stderr, "No server at %s:%d\n", options.host.c_str(), options.port);
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    std::printf("%d connections, %s, %.0fs (+%.0fs warmup), ids 1..%d\n", options.connections,
+                options.keepAlive ? "keep-alive" : "new connection per request", options.duration,
+                options.warmup, options.ids);
+
+    auto recordFrom = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                         std::chrono::duration<double>(options.warmup));
+    auto stopAt = recordFrom + std::chrono::duration_cast<Clock::duration>(
+                                   std::chrono::duration<double>(options.duration));
+
+    std::vector<std::vector<KindStats>> perThread(options.connections, std::vector<KindStats>(KindCount));
+    std::vector<std::thread> threads;
+    for (int i = 0; i < options.connections; ++i)
+        threads.emplace_back(worker, std::cref(options), static_cast<unsigned>(i), recordFrom, stopAt,
+                             std::ref(perThread[i]));
+    for (std::thread &t : threads)
+        t.join();
+
+    std::printf("%-8s %10s %8s %10s %9s %9s %9s %9s %9s\n", "kind", "requests", "errors", "req/s", "MB/s",
+                "p50 ms", "p99 ms", "p999 ms", "max ms");
+    std::vector<uint32_t> all;
+    uint64_t allErrors = 0, allBytes = 0;
+    for (int k = 0; k < KindCount; ++k)
+    {
+        std::vector<uint32_t> latencies;
+        uint64_t errors = 0, bytes = 0;
+        for (const auto &thread : perThread)
+        {
+            latencies.insert(latencies.end(), thread[k].latencyMicros.begin(), thread[k].latencyMicros.end());
+            errors += thread[k].errors;
+            bytes += thread[k].bytes;
+        }
+        if (latencies.empty() && errors == 0)
+            continue;
+        all.insert(all.end(), latencies.begin(), latencies.end());
+        allErrors += errors;
+        allBytes += bytes;
+        printRow(kKindNames[k], latencies, errors, bytes, options.duration);
+    }
+    printRow("total", all, allErrors, allBytes, options.duration);
+    return allErrors > 0 ? 1 : 0;
+}
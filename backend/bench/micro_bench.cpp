@@ -0,0 +1,291 @@
+// Micro-benchmarks for the response hot path: string escaping, recipe
+// serialization and SQLite row decoding, on corpora chosen to stress them
+// (long instructions, non-ASCII text, many characters that need escaping).
+// No server or network needed.
+//
+//   ./bench/micro_bench [filter] [--history=FILE] [--label=NAME] [--host=NAME]
+//                       [--max-regression=PCT]
+//
+// With --history, each result is compared against the latest entry for the
+// same benchmark recorded on the same host (default: this machine's
+// hostname), then appended to FILE. A benchmark that got slower by more than
+// --max-regression percent (default 10) makes the run exit with 1. Timings
+// are machine-specific, so keep FILE out of version control;
+// `make micro_bench MICRO_HISTORY=bench/data/micro_history.csv` does this.
+
+#include "bench.h"
+#include "corpus.h"
+#include "database.h"
+#include "serialize.h"
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+
+struct Benchmark
+{
+    std::string name;
+    size_t bytesPerIter; // input bytes, for MB/s; 0 to skip
+    std::function<void()> fn;
+};
+
+// Text made of `pieces` repeated up to `length` bytes
+std::string repeatText(const std::vector<std::string> &pieces, size_t length)
+{
+    std::string s;
+    for (size_t i = 0; s.size() < length; ++i)
+        s += pieces[i % pieces.size()];
+    s.resize(length);
+    return s;
+}
+
+std::string plainText(size_t length)
+{
+    return repeatText({"Preheat the oven to 180C ", "and whisk the eggs with sugar ", "until pale and fluffy. "},
+                      length);
+}
+
+std::string unicodeText(size_t length)
+{
+    // Mostly multi-byte UTF-8; cut on a piece boundary so it stays valid
+    std::string s = repeatText({"crème fraîche ", "jalapeño ", "naïve façade ", "Crêpes Suzette ",
+                                "抹茶ラテ ", "розмарин ", "🍋🌿 "},
+                               length + 16);
+    while (!s.empty() && (static_cast<unsigned char>(s.back()) & 0xc0) == 0x80)
+        s.pop_back();
+    if (!s.empty() && static_cast<unsigned char>(s.back()) >= 0x80)
+        s.pop_back();
+    return s;
+}
+
+std::string controlText(size_t length)
+{
+    // Pasted text: tabs, CRLF line breaks, quotes, backslashes, stray control bytes
+    return repeatText({"1.\t\"Chop\" onions\r\n", "2.\tC:\\kitchen\\notes\x01\x1f\n", "3.\tServe\b\f\n"}, length);
+}
+
+Recipe longRecipe()
+{
+    Recipe recipe;
+    recipe.id = 1;
+    recipe.title = "Slow-cooked ragù with hand-rolled pappardelle";
+    recipe.description = unicodeText(600);
+    recipe.image_url = "/uploads/1700000000_ragu.jpg";
+    recipe.protein = 42.5;
+    recipe.carbs = 88.25;
+    recipe.cook_time = 240;
+    recipe.difficulty = Difficulty::Hard;
+    recipe.ingredients = plainText(1200);
+    recipe.instructions = controlText(16 * 1024);
+    recipe.created_at = "2025-11-05 12:00:00";
+    return recipe;
+}
+
+size_t listBytes(const std::vector<Recipe> &recipes)
+{
+    size_t bytes = 0;
+    for (const Recipe &r : recipes)
+        bytes += r.title.size() + r.description.size() + r.image_url.size() + r.ingredients.size() +
+                 r.instructions.size() + r.created_at.size();
+    return bytes;
+}
+
+struct HistoryEntry
+{
+    double nsPerIter;
+    std::string label;
+};
+
+// Latest result recorded on `host` per benchmark name
+std::map<std::string, HistoryEntry> loadHistory(const std::string &path, const std::string &host)
+{
+    std::map<std::string, HistoryEntry> latest;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line))
+    {
+        // time,host,label,name,ns_per_iter
+        std::stringstream fields(line);
+        std::string time, entryHost, label, name, ns;
+        if (!std::getline(fields, time, ',') || !std::getline(fields, entryHost, ',') ||
+            !std::getline(fields, label, ',') || !std::getline(fields, name, ',') ||
+            !std::getline(fields, ns, ','))
+            continue;
+        if (entryHost != host)
+            continue;
+        char *end = nullptr;
+        double value = std::strtod(ns.c_str(), &end);
+        if (end == ns.c_str())
+            continue; // header
+        latest[name] = HistoryEntry{value, label};
+    }
+    return latest;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    std::string filter, historyPath, label = "local", host;
+    double maxRegression = 10;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg.compare(0, 10, "--history=") == 0)
+            historyPath = arg.substr(10);
+        else if (arg.compare(0, 8, "--label=") == 0)
+            label = arg.substr(8);
+        else if (arg.compare(0, 7, "--host=") == 0)
+            host = arg.substr(7);
+        else if (arg.compare(0, 17, "--max-regression=") == 0)
+            maxRegression = std::atof(arg.c_str() + 17);
+        else
+            filter = arg;
+    }
+    if (label.empty())
+        label = "local";
+    if (host.empty())
+    {
+        char name[256] = {};
+        host = gethostname(name, sizeof(name) - 1) == 0 && name[0] ? name : "local";
+    }
+
+    // Corpora
+    const std::string plain = plainText(4096);
+    const std::string unicode = unicodeText(4096);
+    const std::string control = controlText(4096);
+    const Recipe longOne = longRecipe();
+    const std::vector<Recipe> typical = bench::makeCorpus(1000);
+    const Recipe &typicalOne = typical[0];
+
+    // A scratch database with the same rows, for decode benchmarks
+    char dbPath[] = "/tmp/micro_bench_XXXXXX";
+    int fd = mkstemp(dbPath);
+    if (fd < 0)
+    {
+        std::perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+    Database db(dbPath);
+    {
+        if (!db.initialize())
+            return 1;
+        BulkInserter inserter(dbPath, typical.size());
+        for (const Recipe &recipe : typical)
+            inserter.insert(recipe);
+        inserter.finish();
+    }
+
+    std::string out;
+    std::vector<Benchmark> benchmarks = {
+        {"jsonEscape/plain_4k", plain.size(), [&]
+         { bench::doNotOptimize(jsonEscape(plain)); }},
+        {"jsonEscape/unicode_4k", unicode.size(), [&]
+         { bench::doNotOptimize(jsonEscape(unicode)); }},
+        {"jsonEscape/control_4k", control.size(), [&]
+         { bench::doNotOptimize(jsonEscape(control)); }},
+        {"recipeToJson/typical", 0, [&]
+         { bench::doNotOptimize(recipeToJson(typicalOne)); }},
+        {"recipeToJson/long_instructions", longOne.instructions.size(), [&]
+         { bench::doNotOptimize(recipeToJson(longOne)); }},
+        {"json/list_1k", listBytes(typical), [&]
+         {
+             const RecipeSerializer &json = serializerFor(RecipeFormat::Json);
+             out.clear();
+             json.beginList(out);
+             for (const Recipe &recipe : typical)
+                 json.appendItem(out, viewOf(recipe), out.size() == 1);
+             json.endList(out);
+             bench::doNotOptimize(out.data());
+         }},
+        {"cbor/list_1k", listBytes(typical), [&]
+         {
+             const RecipeSerializer &cbor = serializerFor(RecipeFormat::Cbor);
+             out.clear();
+             cbor.beginList(out);
+             for (const Recipe &recipe : typical)
+                 cbor.appendItem(out, viewOf(recipe), false);
+             cbor.endList(out);
+             bench::doNotOptimize(out.data());
+         }},
+        {"decode/cursor_1k", listBytes(typical), [&]
+         {
+             RecipeCursor cursor = db.queryAllRecipes();
+             size_t length = 0;
+             cursor.forEach([&](const RecipeView &row)
+                            { length += row.instructions.size(); });
+             bench::doNotOptimize(length);
+         }},
+        {"decode/cursor_to_json_1k", listBytes(typical), [&]
+         {
+             RecipeCursor cursor = db.queryAllRecipes();
+             bench::doNotOptimize(recipesToJson(cursor));
+         }},
+    };
+
+    std::map<std::string, HistoryEntry> history;
+    if (!historyPath.empty())
+        history = loadHistory(historyPath, host);
+
+    std::printf("%-32s %14s %10s %10s\n", "benchmark", "ns/op", "MB/s", "change");
+    std::vector<std::pair<std::string, double>> results;
+    int regressions = 0;
+    for (const Benchmark &b : benchmarks)
+    {
+        if (!filter.empty() && b.name.find(filter) == std::string::npos)
+            continue;
+        bench::Result r = bench::run(b.fn, 0.3);
+        results.emplace_back(b.name, r.nsPerIter);
+
+        std::printf("%-32s %14.1f ", b.name.c_str(), r.nsPerIter);
+        if (b.bytesPerIter > 0)
+            std::printf("%10.1f ", b.bytesPerIter / (r.nsPerIter / 1e3));
+        else
+            std::printf("%10s ", "-");
+
+        auto previous = history.find(b.name);
+        if (previous != history.end())
+        {
+            double change = (r.nsPerIter / previous->second.nsPerIter - 1) * 100;
+            bool regressed = change > maxRegression;
+            regressions += regressed;
+            std::printf("%+9.1f%% vs %s%s", change, previous->second.label.c_str(), regressed ? "  REGRESSION" : "");
+        }
+        std::printf("\n");
+    }
+
+    if (!historyPath.empty())
+    {
+        bool fresh = !std::ifstream(historyPath).good();
+        std::ofstream append(historyPath, std::ios::app);
+        if (fresh)
+            append << "time,host,label,benchmark,ns_per_iter\n";
+        append << std::fixed << std::setprecision(1);
+        long long now = static_cast<long long>(std::time(nullptr));
+        for (const auto &result : results)
+            append << now << "," << host << "," << label << "," << result.first << "," << result.second << "\n";
+    }
+
+    unlink(dbPath);
+    std::string wal = std::string(dbPath) + "-wal", shm = std::string(dbPath) + "-shm";
+    unlink(wal.c_str());
+    unlink(shm.c_str());
+
+    if (regressions > 0)
+    {
+        std::fprintf(stderr, "%d benchmark(s) regressed by more than %.0f%%\n", regressions, maxRegression);
+        return 1;
+    }
+    return 0;
+}
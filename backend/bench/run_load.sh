@@ -0,0 +1,35 @@
+#!/bin/bash
+
+# Runs load_bench against a recipe_server started on a generated dataset.
+#
+#   BENCH_ROWS=100000 SERVER_ARGS="--workers=16" ./bench/run_load.sh [load_bench options]
+#
+# The dataset is built once per size under bench/data/ and reused. The
+# server runs from a scratch directory so the real recipes.db is untouched.
+
+set -e
+
+cd "$(dirname "$0")/.."
+
+ROWS=${BENCH_ROWS:-100000}
+DATA_DIR=bench/data
+WORK_DIR=$DATA_DIR/run
+DATASET=$DATA_DIR/recipes-$ROWS.db
+
+mkdir -p "$DATA_DIR"
+if [ ! -f "$DATASET" ]; then
+    echo "Generating $ROWS recipes..."
+    rm -f "$DATASET.tmp"
+    ./recipe_gen --db="$DATASET.tmp" --count="$ROWS"
+    mv "$DATASET.tmp" "$DATASET"
+fi
+
+rm -rf "$WORK_DIR"
+mkdir -p "$WORK_DIR"
+cp "$DATASET" "$WORK_DIR/recipes.db"
+
+(cd "$WORK_DIR" && RECIPE_BACKUP_INTERVAL=0 exec ../../../recipe_server $SERVER_ARGS > server.log 2>&1) &
+SERVER_PID=$!
+trap 'kill $SERVER_PID 2>/dev/null; wait $SERVER_PID 2>/dev/null || true' EXIT
+
+./bench/load_bench --ids="$ROWS" "$@"
@@ -0,0 +1,157 @@
+#include "change_feed.h"
+#include "serialize.h"
+#include <algorithm>
+#include <cstring>
+
+ChangeFeed::ChangeFeed(uint64_t startChangeSeq)
+    : slots(new Slot[kSlots]), head(0), headChangeSeq(startChangeSeq), evictedChangeSeq(startChangeSeq),
+      overruns(0), streams(0) {
+    for (uint64_t i = 0; i < kSlots; ++i) {
+        slots[i].guard.store(0, std::memory_order_relaxed);
+        slots[i].seq.store(0, std::memory_order_relaxed);
+        slots[i].changeSeq.store(0, std::memory_order_relaxed);
+        slots[i].size.store(0, std::memory_order_relaxed);
+    }
+}
+
+void ChangeFeed::publish(const char* type, uint64_t changeSeq, const std::string& data) {
+    std::lock_guard<std::mutex> writer(publishMutex);
+    uint64_t seq = head.load(std::memory_order_relaxed) + 1;
+    std::string frame = "id: " + std::to_string(changeSeq) + "\nevent: " + type + "\ndata: " + data + "\n\n";
+
+    Slot& slot = slots[seq % kSlots];
+    // The event being overwritten leaves the ring: a client that hasn't
+    // seen it can no longer resume.
+    if (slot.seq.load(std::memory_order_relaxed) != 0) {
+        evictedChangeSeq.store(slot.changeSeq.load(std::memory_order_relaxed), std::memory_order_release);
+    }
+    uint64_t guard = slot.guard.load(std::memory_order_relaxed);
+    slot.guard.store(guard + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.seq.store(seq, std::memory_order_relaxed);
+    slot.changeSeq.store(changeSeq, std::memory_order_relaxed);
+    slot.size.store(static_cast<uint32_t>(frame.size()), std::memory_order_relaxed);
+    for (size_t offset = 0; offset < frame.size(); offset += sizeof(uint64_t)) {
+        uint64_t word = 0;
+        std::memcpy(&word, frame.data() + offset, std::min(sizeof(uint64_t), frame.size() - offset));
+        slot.words[offset / sizeof(uint64_t)].store(word, std::memory_order_relaxed);
+    }
+
+    slot.guard.store(guard + 2, std::memory_order_release);
+    headChangeSeq.store(changeSeq, std::memory_order_release);
+    head.store(seq, std::memory_order_release);
+
+    // Only sleeping streams need the mutex; the ring itself never takes it.
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+    }
+    wake.notify_all();
+}
+
+ChangeFeed::ReadResult ChangeFeed::read(uint64_t seq, std::string& frame) const {
+    uint64_t last = latest();
+    if (seq > last) {
+        return Pending;
+    }
+    if (seq == 0 || last - seq >= kSlots) {
+        return Overrun;
+    }
+
+    const Slot& slot = slots[seq % kSlots];
+    char buffer[kPayloadWords * sizeof(uint64_t)];
+    for (;;) {
+        uint64_t before = slot.guard.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        if (slot.seq.load(std::memory_order_relaxed) != seq) {
+            return Overrun;
+        }
+        uint32_t size = slot.size.load(std::memory_order_relaxed);
+        for (uint32_t offset = 0; offset < size; offset += sizeof(uint64_t)) {
+            uint64_t word = slot.words[offset / sizeof(uint64_t)].load(std::memory_order_relaxed);
+            std::memcpy(buffer + offset, &word, sizeof(uint64_t));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.guard.load(std::memory_order_relaxed) == before) {
+            frame.assign(buffer, size);
+            return Ready;
+        }
+    }
+}
+
+uint64_t ChangeFeed::positionAfter(uint64_t seen) const {
+    uint64_t last = latest();
+    if (seen < evictedChangeSeq.load(std::memory_order_acquire) || seen > latestChangeSeq()) {
+        return 0;
+    }
+    // Positions and change_seqs rise together, so the first newer event is
+    // where the client left off.
+    uint64_t first = last >= kSlots ? last - kSlots + 1 : 1;
+    for (uint64_t seq = first; seq <= last; ++seq) {
+        const Slot& slot = slots[seq % kSlots];
+        bool current;
+        uint64_t changeSeq;
+        for (;;) {
+            uint64_t before = slot.guard.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+            current = slot.seq.load(std::memory_order_relaxed) == seq;
+            changeSeq = slot.changeSeq.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.guard.load(std::memory_order_relaxed) == before) {
+                break;
+            }
+        }
+        // Overwritten during the scan: fine only if the client had seen it
+        if (!current) {
+            if (seen < evictedChangeSeq.load(std::memory_order_acquire)) {
+                return 0;
+            }
+            continue;
+        }
+        if (changeSeq > seen) {
+            return seq;
+        }
+    }
+    return last + 1;
+}
+
+void ChangeFeed::waitAfter(uint64_t seq, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    wake.wait_for(lock, timeout, [&] { return latest() > seq; });
+}
+
+bool ChangeFeed::attach(int maxStreams) {
+    if (streams.fetch_add(1, std::memory_order_relaxed) >= maxStreams) {
+        streams.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void ChangeFeed::recipeStored(const Recipe& recipe) {
+    std::string data = "{\"id\":" + std::to_string(recipe.id) + ",\"version\":" + std::to_string(recipe.version) +
+                       ",\"seq\":" + std::to_string(recipe.change_seq);
+    size_t bare = data.size();
+    data += ",\"recipe\":";
+    appendRecipeJson(data, viewOf(recipe));
+    // Oversized rows go out without the body; clients fetch them by id.
+    if (data.size() + 64 > kPayloadWords * sizeof(uint64_t)) {
+        data.resize(bare);
+    }
+    data += '}';
+    publish(recipe.version <= 1 ? "created" : "updated", static_cast<uint64_t>(recipe.change_seq), data);
+}
+
+void ChangeFeed::recipeDeleted(const RecipeTombstone& tombstone) {
+    publish("deleted", static_cast<uint64_t>(tombstone.change_seq), "{\"id\":" + std::to_string(tombstone.id) + ",\"version\":" +
+                           std::to_string(tombstone.version) + ",\"seq\":" + std::to_string(tombstone.change_seq) + "}");
+}
+
+void ChangeFeed::recipesImported(long long afterSeq, long long throughSeq) {
+    publish("resync", static_cast<uint64_t>(throughSeq),
+            "{\"after\":" + std::to_string(afterSeq) + ",\"through\":" + std::to_string(throughSeq) + "}");
+}
@@ -0,0 +1,90 @@
+#ifndef CHANGE_FEED_H
+#define CHANGE_FEED_H
+
+#include "database.h"
+#include "recipe.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Recent recipe changes as ready-to-send Server-Sent Events. Each event is
+// formatted once by the writer and copied into a fixed ring of seqlocked
+// slots.
+// Any number of streams read the ring without taking a lock or slowing the
+// writer: a reader that falls a full ring behind sees read() return Overrun
+// and has to resynchronize, rather than holding events back.
+// Events are addressed by their position in the ring (numbered from 1 per
+// process), but their SSE id is the change's change_seq, so ids survive a
+// restart and line up with /api/recipes/sync.
+class ChangeFeed : public RecipeObserver {
+public:
+    enum ReadResult { Ready, Pending, Overrun };
+
+    static const uint64_t kSlots = 1024;
+
+private:
+    static const size_t kPayloadWords = 1024;  // 8 KB per event
+
+    struct Slot {
+        std::atomic<uint64_t> guard;  // odd while the writer is in the slot
+        std::atomic<uint64_t> seq;
+        std::atomic<uint64_t> changeSeq;
+        std::atomic<uint32_t> size;
+        std::atomic<uint64_t> words[kPayloadWords];
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<uint64_t> head;  // last published event; 0 before the first
+    std::atomic<uint64_t> headChangeSeq;     // change_seq of the last event (or the start)
+    std::atomic<uint64_t> evictedChangeSeq;  // newest change_seq no longer in the ring
+    std::atomic<uint64_t> overruns;
+    std::atomic<int> streams;
+
+    std::mutex publishMutex;  // writers only; uncontended, Database serializes writes
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+
+    void publish(const char* type, uint64_t changeSeq, const std::string& data);
+
+public:
+    // startChangeSeq is the database's change_seq when the feed starts;
+    // clients that saw it have missed nothing.
+    explicit ChangeFeed(uint64_t startChangeSeq);
+
+    uint64_t latest() const { return head.load(std::memory_order_acquire); }
+    // change_seq of the latest event, at least as new as latest().
+    uint64_t latestChangeSeq() const { return headChangeSeq.load(std::memory_order_acquire); }
+
+    // Position of the first event after change_seq `seen`, latest() + 1 if
+    // there is none yet, or 0 if some of those events already left the ring
+    // (or `seen` is from the future, e.g. another database).
+    uint64_t positionAfter(uint64_t seen) const;
+
+    // Copies event at position `seq` (numbered from 1) into frame as a complete
+    // "id/event/data" block. Pending if it hasn't happened yet, Overrun if
+    // it has already been overwritten.
+    ReadResult read(uint64_t seq, std::string& frame) const;
+
+    // Blocks until an event after `seq` is published or the timeout passes.
+    void waitAfter(uint64_t seq, std::chrono::milliseconds timeout);
+
+    // Reserves one of maxStreams stream slots; false when all are taken.
+    bool attach(int maxStreams);
+    void detach() { streams.fetch_sub(1, std::memory_order_relaxed); }
+    int streamCount() const { return streams.load(std::memory_order_relaxed); }
+
+    uint64_t overrunCount() const { return overruns.load(std::memory_order_relaxed); }
+    void countOverrun() { overruns.fetch_add(1, std::memory_order_relaxed); }
+
+    void recipeStored(const Recipe& recipe) override;
+    void recipeDeleted(const RecipeTombstone& tombstone) override;
+    // One "resync" event for the whole range: clients fetch the rows
+    // through /api/recipes/sync instead of reading one event each.
+    void recipesImported(long long afterSeq, long long throughSeq) override;
+};
+
+#endif
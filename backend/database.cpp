@@ -1,24 +1,115 @@
 #include "database.h"
+#include "metrics.h"
+#include "slow_query_log.h"
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
-Database::Database(const std::string& path) : db(nullptr), db_path(path) {}
+namespace {
+
+// Bump kSchemaVersion and append to kMigrations whenever kSchema changes;
+// schema.sql must be kept in step with kSchema.
+const int kSchemaVersion = 3;
+
+const int kBusyTimeoutMs = 5000;
+
+const char* kInsertRecipe = R"(
+    INSERT INTO recipes (title, description, image_url, protein, carbs,
+                        is_vegan, is_vegetarian, is_gluten_free,
+                        cook_time, difficulty, ingredients, instructions,
+                        created_at, change_seq)
+    VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, COALESCE(?, CURRENT_TIMESTAMP),
+            COALESCE(?, 0))
+)";
+
+// The server's writes return the stored row so observers see exactly what
+// was committed, without a second query.
+const std::string kInsertRecipeReturning = std::string(kInsertRecipe) + " RETURNING *";
+
+// Binds parameters 1-12 in kInsertRecipe / UPDATE column order. Text is bound
+// SQLITE_STATIC, so the recipe must outlive the statement's next step.
+void bindRecipe(sqlite3_stmt* stmt, const Recipe& recipe) {
+    sqlite3_bind_text(stmt, 1, recipe.title.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, recipe.description.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, recipe.image_url.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_double(stmt, 4, recipe.protein);
+    sqlite3_bind_double(stmt, 5, recipe.carbs);
+    sqlite3_bind_int(stmt, 6, recipe.is_vegan ? 1 : 0);
+    sqlite3_bind_int(stmt, 7, recipe.is_vegetarian ? 1 : 0);
+    sqlite3_bind_int(stmt, 8, recipe.is_gluten_free ? 1 : 0);
+    sqlite3_bind_int(stmt, 9, recipe.cook_time);
+    sqlite3_bind_int(stmt, 10, static_cast<int>(recipe.difficulty));
+    sqlite3_bind_text(stmt, 11, recipe.ingredients.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 12, recipe.instructions.c_str(), -1, SQLITE_STATIC);
+}
 
-Database::~Database() {
-    if (db) {
-        sqlite3_close(db);
+// Parameter 13 of kInsertRecipe: an empty created_at means "now". Parameter
+// 14, change_seq, is left unbound (0) by the bulk importer; those rows are
+// numbered afterwards by Database::sequenceNewRows.
+void bindCreatedAt(sqlite3_stmt* stmt, const Recipe& recipe) {
+    if (recipe.created_at.empty()) {
+        sqlite3_bind_null(stmt, 13);
+    } else {
+        sqlite3_bind_text(stmt, 13, recipe.created_at.c_str(), -1, SQLITE_STATIC);
     }
 }
 
-bool Database::initialize() {
-    int rc = sqlite3_open(db_path.c_str(), &db);
-    if (rc != SQLITE_OK) {
-        std::cerr << "Can't open database: " << sqlite3_errmsg(db) << std::endl;
-        return false;
-    }
+const char* kSchema = R"(
+    CREATE TABLE IF NOT EXISTS difficulties (
+        rank INTEGER PRIMARY KEY,
+        name TEXT NOT NULL UNIQUE
+    );
+
+    INSERT OR IGNORE INTO difficulties (rank, name) VALUES
+        (1, 'easy'), (2, 'medium'), (3, 'hard');
+
+    CREATE TABLE IF NOT EXISTS recipes (
+        id INTEGER PRIMARY KEY AUTOINCREMENT,
+        title TEXT NOT NULL,
+        description TEXT NOT NULL,
+        image_url TEXT,
+        protein REAL DEFAULT 0,
+        carbs REAL DEFAULT 0,
+        is_vegan INTEGER DEFAULT 0,
+        is_vegetarian INTEGER DEFAULT 0,
+        is_gluten_free INTEGER DEFAULT 0,
+        cook_time INTEGER DEFAULT 0,
+        difficulty INTEGER NOT NULL DEFAULT 2 REFERENCES difficulties(rank),
+        ingredients TEXT NOT NULL,
+        instructions TEXT NOT NULL,
+        created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+        version INTEGER NOT NULL DEFAULT 1,
+        change_seq INTEGER NOT NULL DEFAULT 0
+    );
+
+    CREATE INDEX IF NOT EXISTS idx_recipes_cook_time ON recipes(cook_time);
+    CREATE INDEX IF NOT EXISTS idx_recipes_difficulty ON recipes(difficulty);
+    CREATE INDEX IF NOT EXISTS idx_recipes_created_at ON recipes(created_at);
+    CREATE INDEX IF NOT EXISTS idx_recipes_change_seq ON recipes(change_seq);
+
+    CREATE TABLE IF NOT EXISTS recipe_tombstones (
+        id INTEGER PRIMARY KEY,
+        version INTEGER NOT NULL,
+        change_seq INTEGER NOT NULL
+    );
+
+    CREATE INDEX IF NOT EXISTS idx_recipe_tombstones_change_seq ON recipe_tombstones(change_seq);
+)";
+
+// kMigrations[v] upgrades a database at user_version v to v + 1.
+const char* kMigrations[] = {
+    // 0 -> 1: difficulty TEXT ('easy'/'medium'/'hard') becomes an integer
+    // rank. SQLite can't change a column type in place, so rebuild the table.
+    R"(
+        CREATE TABLE difficulties (
+            rank INTEGER PRIMARY KEY,
+            name TEXT NOT NULL UNIQUE
+        );
 
-    std::string schema = R"(
-        CREATE TABLE IF NOT EXISTS recipes (
+        INSERT INTO difficulties (rank, name) VALUES
+            (1, 'easy'), (2, 'medium'), (3, 'hard');
+
+        CREATE TABLE recipes_new (
             id INTEGER PRIMARY KEY AUTOINCREMENT,
             title TEXT NOT NULL,
             description TEXT NOT NULL,
@@ -29,65 +120,271 @@ bool Database::initialize() {
             is_vegetarian INTEGER DEFAULT 0,
             is_gluten_free INTEGER DEFAULT 0,
             cook_time INTEGER DEFAULT 0,
-            difficulty TEXT DEFAULT 'medium',
+            difficulty INTEGER NOT NULL DEFAULT 2 REFERENCES difficulties(rank),
             ingredients TEXT NOT NULL,
             instructions TEXT NOT NULL,
             created_at DATETIME DEFAULT CURRENT_TIMESTAMP
         );
-    )";
 
-    char* errMsg;
-    rc = sqlite3_exec(db, schema.c_str(), nullptr, nullptr, &errMsg);
+        INSERT INTO recipes_new
+        SELECT id, title, description, image_url, protein, carbs,
+               is_vegan, is_vegetarian, is_gluten_free, cook_time,
+               COALESCE((SELECT rank FROM difficulties
+                         WHERE name = lower(trim(recipes.difficulty))), 2),
+               ingredients, instructions, created_at
+        FROM recipes;
+
+        DROP TABLE recipes;
+        ALTER TABLE recipes_new RENAME TO recipes;
+
+        CREATE INDEX idx_recipes_cook_time ON recipes(cook_time);
+        CREATE INDEX idx_recipes_difficulty ON recipes(difficulty);
+        CREATE INDEX idx_recipes_created_at ON recipes(created_at);
+    )",
+
+    // 1 -> 2: per-row version, bumped on update, so change events and
+    // clients can tell which copy of a row is newer.
+    R"(
+        ALTER TABLE recipes ADD COLUMN version INTEGER NOT NULL DEFAULT 1;
+    )",
+
+    // 2 -> 3: change sequence and tombstones for delta sync. Existing rows
+    // start at 0 and are numbered by sequenceNewRows() on startup.
+    R"(
+        ALTER TABLE recipes ADD COLUMN change_seq INTEGER NOT NULL DEFAULT 0;
+        CREATE INDEX idx_recipes_change_seq ON recipes(change_seq);
+
+        CREATE TABLE recipe_tombstones (
+            id INTEGER PRIMARY KEY,
+            version INTEGER NOT NULL,
+            change_seq INTEGER NOT NULL
+        );
+        CREATE INDEX idx_recipe_tombstones_change_seq ON recipe_tombstones(change_seq);
+    )",
+};
+
+}
+
+ReaderPool::ReaderPool(const std::string& path) : path(path) {}
+
+ReaderPool::~ReaderPool() {
+    for (sqlite3* connection : idle) {
+        sqlite3_close(connection);
+    }
+}
+
+std::shared_ptr<sqlite3> ReaderPool::acquire() {
+    sqlite3* connection = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!idle.empty()) {
+            connection = idle.back();
+            idle.pop_back();
+        }
+    }
+    if (!connection) {
+        if (sqlite3_open_v2(path.c_str(), &connection, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+            std::cerr << "Can't open reader: " << (connection ? sqlite3_errmsg(connection) : "out of memory")
+                      << std::endl;
+            sqlite3_close(connection);
+            return nullptr;
+        }
+        sqlite3_busy_timeout(connection, kBusyTimeoutMs);
+        SlowQueryLog::attach(connection);
+    }
+    std::shared_ptr<ReaderPool> self = shared_from_this();
+    return std::shared_ptr<sqlite3>(connection, [self](sqlite3* c) { self->release(c); });
+}
+
+void ReaderPool::release(sqlite3* connection) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (idle.size() < kMaxIdle) {
+            idle.push_back(connection);
+            return;
+        }
+    }
+    sqlite3_close(connection);
+}
+
+Database::Database(const std::string& path)
+    : db(nullptr), db_path(path), readers(std::make_shared<ReaderPool>(path)), lastChangeSeq(0) {}
+
+Database::~Database() {
+    if (db) {
+        sqlite3_close(db);
+    }
+}
+
+bool Database::initialize() {
+    int rc = sqlite3_open(db_path.c_str(), &db);
+    if (rc != SQLITE_OK) {
+        std::cerr << "Can't open database: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+
+    // WAL lets readers (and the bulk importer's separate connection) run
+    // alongside a writer; writers wait on each other instead of failing.
+    sqlite3_busy_timeout(db, kBusyTimeoutMs);
+    SlowQueryLog::attach(db);
+    if (!exec("PRAGMA journal_mode = WAL") || !exec("PRAGMA synchronous = NORMAL")) {
+        return false;
+    }
+
+    if (!tableExists("recipes")) {
+        return exec(kSchema) && setSchemaVersion(kSchemaVersion);
+    }
+
+    int version = schemaVersion();
+    while (version < kSchemaVersion) {
+        std::cout << "Migrating database schema to version " << version + 1 << std::endl;
+        if (!exec("BEGIN") || !exec(kMigrations[version]) || !setSchemaVersion(version + 1)) {
+            exec("ROLLBACK");
+            return false;
+        }
+        if (!exec("COMMIT")) {
+            return false;
+        }
+        ++version;
+    }
+
+    return sequenceNewRows();
+}
+
+bool Database::exec(const std::string& sql) {
+    char* errMsg = nullptr;
+    int rc = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg);
     if (rc != SQLITE_OK) {
         std::cerr << "SQL error: " << errMsg << std::endl;
         sqlite3_free(errMsg);
         return false;
     }
-
     return true;
 }
 
-std::vector<Recipe> Database::getAllRecipes() {
-    std::vector<Recipe> recipes;
-    std::string query = "SELECT * FROM recipes ORDER BY created_at DESC";
+bool Database::tableExists(const std::string& name) {
+    std::string query = "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = ?";
+    sqlite3_stmt* stmt;
 
+    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+
+    sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_TRANSIENT);
+    bool exists = sqlite3_step(stmt) == SQLITE_ROW;
+    sqlite3_finalize(stmt);
+    return exists;
+}
+
+int Database::schemaVersion() {
     sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr);
+    int version = 0;
 
-    if (rc != SQLITE_OK) {
+    if (sqlite3_prepare_v2(db, "PRAGMA user_version", -1, &stmt, nullptr) != SQLITE_OK) {
         std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
-        return recipes;
+        return version;
     }
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        Recipe recipe;
-        recipe.id = sqlite3_column_int(stmt, 0);
-        recipe.title = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        recipe.description = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        recipe.image_url = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        recipe.protein = sqlite3_column_double(stmt, 4);
-        recipe.carbs = sqlite3_column_double(stmt, 5);
-        recipe.is_vegan = sqlite3_column_int(stmt, 6);
-        recipe.is_vegetarian = sqlite3_column_int(stmt, 7);
-        recipe.is_gluten_free = sqlite3_column_int(stmt, 8);
-        recipe.cook_time = sqlite3_column_int(stmt, 9);
-        recipe.difficulty = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 10));
-        recipe.ingredients = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 11));
-        recipe.instructions = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 12));
-        recipe.created_at = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 13));
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        version = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return version;
+}
+
+bool Database::setSchemaVersion(int version) {
+    return exec("PRAGMA user_version = " + std::to_string(version));
+}
+
+long long Database::maxChangeSeq() {
+    const char* query = R"(
+        SELECT max((SELECT COALESCE(max(change_seq), 0) FROM recipes),
+                   (SELECT COALESCE(max(change_seq), 0) FROM recipe_tombstones))
+    )";
+    sqlite3_stmt* stmt;
+    long long seq = 0;
 
-        recipes.push_back(recipe);
+    if (sqlite3_prepare_v2(db, query, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        return seq;
     }
 
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        seq = sqlite3_column_int64(stmt, 0);
+    }
     sqlite3_finalize(stmt);
-    return recipes;
+    return seq;
+}
+
+long long Database::latestChangeSeq() {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    return lastChangeSeq;
 }
 
-std::vector<Recipe> Database::filterRecipes(double minProtein, double maxProtein,
-                                             double minCarbs, double maxCarbs,
-                                             bool veganOnly, bool vegetarianOnly,
-                                             bool glutenFreeOnly) {
-    std::vector<Recipe> recipes;
+bool Database::sequenceNewRows(ChangeRange* numbered) {
+    PhaseTimer timer(Metrics::PhaseDb);
+    std::lock_guard<std::mutex> lock(writeMutex);
+    long long base = std::max(lastChangeSeq, maxChangeSeq());
+
+    // Ids are unique and positive, so base + id gives each row its own
+    // number above everything already sequenced.
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "UPDATE recipes SET change_seq = ? + id WHERE change_seq = 0", -1, &stmt,
+                           nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    sqlite3_bind_int64(stmt, 1, base);
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Failed to sequence new rows: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    bool changed = sqlite3_changes(db) > 0;
+    lastChangeSeq = std::max(base, maxChangeSeq());
+    if (numbered) {
+        numbered->after = base;
+        numbered->through = changed ? lastChangeSeq : base;
+    }
+    if (changed) {
+        for (RecipeObserver* observer : observers) {
+            observer->recipesImported(base, lastChangeSeq);
+        }
+    }
+    return true;
+}
+
+RecipeCursor Database::prepareRecipes(const std::string& query,
+                                      const std::function<void(sqlite3_stmt*)>& bind) {
+    PhaseTimer timer(Metrics::PhaseDb);
+    std::shared_ptr<sqlite3> reader = readers->acquire();
+    if (!reader) {
+        return RecipeCursor();
+    }
+
+    sqlite3_stmt* stmt;
+    int rc = sqlite3_prepare_v2(reader.get(), query.c_str(), -1, &stmt, nullptr);
+    if (rc != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(reader.get()) << std::endl;
+        return RecipeCursor();
+    }
+
+    if (bind) {
+        bind(stmt);
+    }
+    return RecipeCursor(stmt, std::move(reader));
+}
+
+RecipeCursor Database::queryAllRecipes() {
+    return prepareRecipes("SELECT * FROM recipes ORDER BY created_at DESC");
+}
+
+RecipeCursor Database::queryFilteredRecipes(double minProtein, double maxProtein,
+                                            double minCarbs, double maxCarbs,
+                                            bool veganOnly, bool vegetarianOnly,
+                                            bool glutenFreeOnly) {
     std::stringstream query;
 
     query << "SELECT * FROM recipes WHERE 1=1";
@@ -102,40 +399,11 @@ std::vector<Recipe> Database::filterRecipes(double minProtein, double maxProtein
 
     query << " ORDER BY created_at DESC";
 
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(db, query.str().c_str(), -1, &stmt, nullptr);
-
-    if (rc != SQLITE_OK) {
-        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
-        return recipes;
-    }
-
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        Recipe recipe;
-        recipe.id = sqlite3_column_int(stmt, 0);
-        recipe.title = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        recipe.description = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        recipe.image_url = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        recipe.protein = sqlite3_column_double(stmt, 4);
-        recipe.carbs = sqlite3_column_double(stmt, 5);
-        recipe.is_vegan = sqlite3_column_int(stmt, 6);
-        recipe.is_vegetarian = sqlite3_column_int(stmt, 7);
-        recipe.is_gluten_free = sqlite3_column_int(stmt, 8);
-        recipe.cook_time = sqlite3_column_int(stmt, 9);
-        recipe.difficulty = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 10));
-        recipe.ingredients = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 11));
-        recipe.instructions = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 12));
-        recipe.created_at = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 13));
-
-        recipes.push_back(recipe);
-    }
-
-    sqlite3_finalize(stmt);
-    return recipes;
+    return prepareRecipes(query.str());
 }
 
-std::vector<Recipe> Database::sortRecipes(const std::string& sortBy, const std::string& order) {
-    std::vector<Recipe> recipes;
+RecipeCursor Database::querySortedRecipes(const std::string& sortBy, const std::string& order,
+                                          int limit) {
     std::stringstream query;
 
     query << "SELECT * FROM recipes ORDER BY ";
@@ -148,123 +416,124 @@ std::vector<Recipe> Database::sortRecipes(const std::string& sortBy, const std::
         query << "created_at";
     }
 
-    if (order == "asc") {
-        query << " ASC";
-    } else {
-        query << " DESC";
-    }
-
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(db, query.str().c_str(), -1, &stmt, nullptr);
+    // The id tie-break keeps pages stable and still lets SQLite walk the
+    // single-column index (every index entry carries the rowid).
+    const char* direction = (order == "asc") ? " ASC" : " DESC";
+    query << direction << ", id" << direction;
 
-    if (rc != SQLITE_OK) {
-        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
-        return recipes;
+    // With a limit SQLite reads the first K entries of the index instead of
+    // sorting the whole table, so a first-page request is O(K log N).
+    if (limit > 0) {
+        query << " LIMIT ?";
     }
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        Recipe recipe;
-        recipe.id = sqlite3_column_int(stmt, 0);
-        recipe.title = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        recipe.description = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        recipe.image_url = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        recipe.protein = sqlite3_column_double(stmt, 4);
-        recipe.carbs = sqlite3_column_double(stmt, 5);
-        recipe.is_vegan = sqlite3_column_int(stmt, 6);
-        recipe.is_vegetarian = sqlite3_column_int(stmt, 7);
-        recipe.is_gluten_free = sqlite3_column_int(stmt, 8);
-        recipe.cook_time = sqlite3_column_int(stmt, 9);
-        recipe.difficulty = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 10));
-        recipe.ingredients = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 11));
-        recipe.instructions = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 12));
-        recipe.created_at = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 13));
+    return prepareRecipes(query.str(), [limit](sqlite3_stmt* stmt) {
+        if (limit > 0) {
+            sqlite3_bind_int(stmt, 1, limit);
+        }
+    });
+}
 
-        recipes.push_back(recipe);
+RecipeCursor Database::queryRecipesByIds(const std::vector<int>& ids) {
+    // The list is bound as one JSON array; json_each yields it in order
+    // (key is the position) and each element is a primary-key lookup.
+    std::string query = R"(
+        SELECT recipes.* FROM json_each(?) AS wanted
+        JOIN recipes ON recipes.id = wanted.value
+        ORDER BY wanted.key
+    )";
+
+    std::string list = "[";
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (i > 0) {
+            list += ',';
+        }
+        list += std::to_string(ids[i]);
     }
+    list += ']';
+    return prepareRecipes(query, [&list](sqlite3_stmt* stmt) {
+        sqlite3_bind_text(stmt, 1, list.c_str(), static_cast<int>(list.size()), SQLITE_TRANSIENT);
+    });
+}
 
-    sqlite3_finalize(stmt);
-    return recipes;
+RecipeCursor Database::querySortKeys(long long afterSeq, long long throughSeq, int limit) {
+    const char* query = R"(
+        SELECT id, created_at, cook_time, difficulty, change_seq FROM recipes
+        WHERE change_seq > ? AND change_seq <= ?
+        ORDER BY change_seq LIMIT ?
+    )";
+    return prepareRecipes(query, [=](sqlite3_stmt* stmt) {
+        sqlite3_bind_int64(stmt, 1, afterSeq);
+        sqlite3_bind_int64(stmt, 2, throughSeq);
+        sqlite3_bind_int(stmt, 3, limit);
+    });
 }
 
 Recipe Database::getRecipeById(int id) {
     Recipe recipe;
     recipe.id = -1;
 
-    std::string query = "SELECT * FROM recipes WHERE id = ?";
-    sqlite3_stmt* stmt;
-
-    int rc = sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
-        return recipe;
+    RecipeCursor cursor = prepareRecipes("SELECT * FROM recipes WHERE id = ?",
+                                         [id](sqlite3_stmt* stmt) { sqlite3_bind_int(stmt, 1, id); });
+    if (cursor.next()) {
+        recipe = recipeFromView(cursor.row());
     }
 
-    sqlite3_bind_int(stmt, 1, id);
+    return recipe;
+}
 
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-        recipe.id = sqlite3_column_int(stmt, 0);
-        recipe.title = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        recipe.description = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        recipe.image_url = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        recipe.protein = sqlite3_column_double(stmt, 4);
-        recipe.carbs = sqlite3_column_double(stmt, 5);
-        recipe.is_vegan = sqlite3_column_int(stmt, 6);
-        recipe.is_vegetarian = sqlite3_column_int(stmt, 7);
-        recipe.is_gluten_free = sqlite3_column_int(stmt, 8);
-        recipe.cook_time = sqlite3_column_int(stmt, 9);
-        recipe.difficulty = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 10));
-        recipe.ingredients = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 11));
-        recipe.instructions = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 12));
-        recipe.created_at = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 13));
+// Steps a write ending in RETURNING * and reports the row, if any, to the
+// observers. Callers hold writeMutex so observers see commit order.
+bool Database::storeReturning(sqlite3_stmt* stmt) {
+    RecipeCursor cursor(stmt);
+    bool found = cursor.next();
+    Recipe stored;
+    if (found) {
+        stored = recipeFromView(cursor.row());
     }
-
-    sqlite3_finalize(stmt);
-    return recipe;
+    while (cursor.next()) {
+    }
+    if (!cursor.ok()) {
+        return false;
+    }
+    if (found) {
+        for (RecipeObserver* observer : observers) {
+            observer->recipeStored(stored);
+        }
+    }
+    return true;
 }
 
 bool Database::addRecipe(const Recipe& recipe) {
-    std::string query = R"(
-        INSERT INTO recipes (title, description, image_url, protein, carbs,
-                            is_vegan, is_vegetarian, is_gluten_free,
-                            cook_time, difficulty, ingredients, instructions)
-        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
-    )";
-
+    PhaseTimer timer(Metrics::PhaseDb);
+    std::lock_guard<std::mutex> lock(writeMutex);
     sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr);
+    int rc = sqlite3_prepare_v2(db, kInsertRecipeReturning.c_str(), -1, &stmt, nullptr);
 
     if (rc != SQLITE_OK) {
         std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
         return false;
     }
 
-    sqlite3_bind_text(stmt, 1, recipe.title.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, recipe.description.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, recipe.image_url.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_double(stmt, 4, recipe.protein);
-    sqlite3_bind_double(stmt, 5, recipe.carbs);
-    sqlite3_bind_int(stmt, 6, recipe.is_vegan ? 1 : 0);
-    sqlite3_bind_int(stmt, 7, recipe.is_vegetarian ? 1 : 0);
-    sqlite3_bind_int(stmt, 8, recipe.is_gluten_free ? 1 : 0);
-    sqlite3_bind_int(stmt, 9, recipe.cook_time);
-    sqlite3_bind_text(stmt, 10, recipe.difficulty.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 11, recipe.ingredients.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 12, recipe.instructions.c_str(), -1, SQLITE_TRANSIENT);
-
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    bindRecipe(stmt, recipe);
+    bindCreatedAt(stmt, recipe);
+    sqlite3_bind_int64(stmt, 14, ++lastChangeSeq);
 
-    return rc == SQLITE_DONE;
+    return storeReturning(stmt);
 }
 
 bool Database::updateRecipe(int id, const Recipe& recipe) {
+    PhaseTimer timer(Metrics::PhaseDb);
+    std::lock_guard<std::mutex> lock(writeMutex);
     std::string query = R"(
         UPDATE recipes SET title = ?, description = ?, image_url = ?,
                           protein = ?, carbs = ?, is_vegan = ?,
                           is_vegetarian = ?, is_gluten_free = ?,
                           cook_time = ?, difficulty = ?,
-                          ingredients = ?, instructions = ?
+                          ingredients = ?, instructions = ?,
+                          version = version + 1, change_seq = ?
         WHERE id = ?
+        RETURNING *
     )";
 
     sqlite3_stmt* stmt;
@@ -275,39 +544,288 @@ bool Database::updateRecipe(int id, const Recipe& recipe) {
         return false;
     }
 
-    sqlite3_bind_text(stmt, 1, recipe.title.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, recipe.description.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, recipe.image_url.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_double(stmt, 4, recipe.protein);
-    sqlite3_bind_double(stmt, 5, recipe.carbs);
-    sqlite3_bind_int(stmt, 6, recipe.is_vegan ? 1 : 0);
-    sqlite3_bind_int(stmt, 7, recipe.is_vegetarian ? 1 : 0);
-    sqlite3_bind_int(stmt, 8, recipe.is_gluten_free ? 1 : 0);
-    sqlite3_bind_int(stmt, 9, recipe.cook_time);
-    sqlite3_bind_text(stmt, 10, recipe.difficulty.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 11, recipe.ingredients.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 12, recipe.instructions.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 13, id);
-
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    bindRecipe(stmt, recipe);
+    sqlite3_bind_int64(stmt, 13, ++lastChangeSeq);
+    sqlite3_bind_int(stmt, 14, id);
 
-    return rc == SQLITE_DONE;
+    return storeReturning(stmt);
 }
 
 bool Database::deleteRecipe(int id) {
-    std::string query = "DELETE FROM recipes WHERE id = ?";
+    PhaseTimer timer(Metrics::PhaseDb);
+    std::lock_guard<std::mutex> lock(writeMutex);
+    // The row and its tombstone go in one transaction, so a sync never sees
+    // one without the other.
+    if (!exec("BEGIN")) {
+        return false;
+    }
+
+    std::string query = "DELETE FROM recipes WHERE id = ? RETURNING version";
     sqlite3_stmt* stmt;
 
     int rc = sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr);
     if (rc != SQLITE_OK) {
         std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        exec("ROLLBACK");
         return false;
     }
 
     sqlite3_bind_int(stmt, 1, id);
-    rc = sqlite3_step(stmt);
+    bool deleted = false;
+    RecipeTombstone tombstone = {id, 0, 0};
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        deleted = true;
+        tombstone.version = sqlite3_column_int(stmt, 0) + 1;
+    }
     sqlite3_finalize(stmt);
 
+    if (rc == SQLITE_DONE && deleted) {
+        tombstone.change_seq = ++lastChangeSeq;
+        query = "INSERT OR REPLACE INTO recipe_tombstones (id, version, change_seq) VALUES (?, ?, ?)";
+        rc = sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr);
+        if (rc == SQLITE_OK) {
+            sqlite3_bind_int(stmt, 1, tombstone.id);
+            sqlite3_bind_int(stmt, 2, tombstone.version);
+            sqlite3_bind_int64(stmt, 3, tombstone.change_seq);
+            rc = sqlite3_step(stmt);
+            sqlite3_finalize(stmt);
+        }
+    }
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Failed to delete recipe: " << sqlite3_errmsg(db) << std::endl;
+        exec("ROLLBACK");
+        return false;
+    }
+    if (!exec("COMMIT")) {
+        exec("ROLLBACK");
+        return false;
+    }
+
+    if (deleted) {
+        for (RecipeObserver* observer : observers) {
+            observer->recipeDeleted(tombstone);
+        }
+    }
+    return true;
+}
+
+bool Database::deleteAllRecipes() {
+    PhaseTimer timer(Metrics::PhaseDb);
+    std::lock_guard<std::mutex> lock(writeMutex);
+    if (!exec("BEGIN IMMEDIATE")) {
+        return false;
+    }
+
+    // Numbered like sequenceNewRows(): base + id is unique per row and above
+    // everything sequenced so far.
+    long long base = std::max(lastChangeSeq, maxChangeSeq());
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, R"(
+            INSERT OR REPLACE INTO recipe_tombstones (id, version, change_seq)
+            SELECT id, version + 1, ? + id FROM recipes
+        )", -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        exec("ROLLBACK");
+        return false;
+    }
+    sqlite3_bind_int64(stmt, 1, base);
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Failed to write tombstones: " << sqlite3_errmsg(db) << std::endl;
+        exec("ROLLBACK");
+        return false;
+    }
+    if (!exec("DELETE FROM recipes") || !exec("COMMIT")) {
+        exec("ROLLBACK");
+        return false;
+    }
+
+    lastChangeSeq = std::max(base, maxChangeSeq());
+    return true;
+}
+
+BulkInserter::BulkInserter(const std::string& path, size_t batchSize, bool fastLoad, RejectHandler onReject)
+    : db(nullptr), stmt(nullptr), batchSize(batchSize > 0 ? batchSize : 1), inserted(0), failed(false),
+      onReject(onReject) {
+    if (sqlite3_open(path.c_str(), &db) != SQLITE_OK) {
+        fail("Can't open database");
+        return;
+    }
+    sqlite3_busy_timeout(db, kBusyTimeoutMs);
+    SlowQueryLog::attach(db);
+
+    // No fsync at commit and a 256 MiB page cache. Under WAL an application
+    // crash still can't corrupt the file, but an OS crash may.
+    if (fastLoad && (!exec("PRAGMA synchronous = OFF") || !exec("PRAGMA cache_size = -262144") ||
+                     !exec("PRAGMA temp_store = MEMORY"))) {
+        return;
+    }
+
+    if (sqlite3_prepare_v2(db, kInsertRecipe, -1, &stmt, nullptr) != SQLITE_OK) {
+        fail("Failed to prepare statement");
+    }
+}
+
+BulkInserter::~BulkInserter() {
+    if (!queued.empty() && !failed) {
+        flush();
+    }
+    if (stmt) {
+        sqlite3_finalize(stmt);
+    }
+    if (db) {
+        sqlite3_close(db);
+    }
+}
+
+bool BulkInserter::exec(const char* sql) {
+    if (sqlite3_exec(db, sql, nullptr, nullptr, nullptr) != SQLITE_OK) {
+        return fail(sql);
+    }
+    return true;
+}
+
+bool BulkInserter::fail(const std::string& context) {
+    error = context + ": " + (db ? sqlite3_errmsg(db) : "out of memory");
+    std::cerr << "Bulk import: " << error << std::endl;
+    failed = true;
+    if (db && !sqlite3_get_autocommit(db)) {
+        sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+    }
+    return false;
+}
+
+bool BulkInserter::insert(const Recipe& recipe, size_t line) {
+    if (failed) {
+        return false;
+    }
+    queued.emplace_back(line, recipe);
+    if (queued.size() >= batchSize) {
+        return flush();
+    }
+    return true;
+}
+
+bool BulkInserter::flush() {
+    if (failed) {
+        return false;
+    }
+    if (queued.empty()) {
+        return true;
+    }
+    PhaseTimer timer(Metrics::PhaseDb);
+    if (!exec("BEGIN IMMEDIATE")) {
+        return false;
+    }
+
+    size_t written = 0;
+    for (const std::pair<size_t, Recipe>& row : queued) {
+        bindRecipe(stmt, row.second);
+        bindCreatedAt(stmt, row.second);
+        int rc = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+
+        if (rc == SQLITE_DONE) {
+            ++written;
+        } else if ((rc & 0xff) == SQLITE_CONSTRAINT) {
+            // Constraint violations only reject this row
+            if (onReject) {
+                onReject(row.first, sqlite3_errmsg(db));
+            }
+        } else {
+            // Anything else (disk full, I/O error, lock timeout) stops the import
+            return fail("Insert failed");
+        }
+    }
+    queued.clear();
+
+    if (!exec("COMMIT")) {
+        return false;
+    }
+    inserted += written;
+    return true;
+}
+
+SnapshotReader::SnapshotReader(const std::string& path) : db(nullptr), ready(false) {
+    if (sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        std::cerr << "Can't open snapshot: " << (db ? sqlite3_errmsg(db) : "out of memory") << std::endl;
+        return;
+    }
+    sqlite3_busy_timeout(db, kBusyTimeoutMs);
+    ready = sqlite3_exec(db, "BEGIN", nullptr, nullptr, nullptr) == SQLITE_OK;
+}
+
+SnapshotReader::~SnapshotReader() {
+    if (db) {
+        if (!sqlite3_get_autocommit(db)) {
+            sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr);
+        }
+        // _v2 defers the close if a cursor from recipesAfter() is still open
+        sqlite3_close_v2(db);
+    }
+}
+
+RecipeCursor SnapshotReader::recipesAfter(int afterId, int limit) {
+    if (!ready) {
+        return RecipeCursor();
+    }
+
+    // Primary-key range scan, so resuming deep into a large export costs
+    // nothing extra.
+    std::string query = "SELECT * FROM recipes WHERE id > ? ORDER BY id LIMIT ?";
+    sqlite3_stmt* stmt;
+
+    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        return RecipeCursor();
+    }
+
+    sqlite3_bind_int(stmt, 1, afterId);
+    sqlite3_bind_int(stmt, 2, limit > 0 ? limit : -1);
+    return RecipeCursor(stmt);
+}
+
+RecipeCursor SnapshotReader::changesSince(long long seq, int limit) {
+    if (!ready) {
+        return RecipeCursor();
+    }
+
+    std::string query = "SELECT * FROM recipes WHERE change_seq > ? ORDER BY change_seq LIMIT ?";
+    sqlite3_stmt* stmt;
+
+    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        return RecipeCursor();
+    }
+
+    sqlite3_bind_int64(stmt, 1, seq);
+    sqlite3_bind_int(stmt, 2, limit > 0 ? limit : -1);
+    return RecipeCursor(stmt);
+}
+
+bool SnapshotReader::tombstonesSince(long long seq, int limit, std::vector<RecipeTombstone>& out) {
+    if (!ready) {
+        return false;
+    }
+
+    std::string query = R"(
+        SELECT id, version, change_seq FROM recipe_tombstones
+        WHERE change_seq > ? ORDER BY change_seq LIMIT ?
+    )";
+    sqlite3_stmt* stmt;
+
+    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+
+    sqlite3_bind_int64(stmt, 1, seq);
+    sqlite3_bind_int(stmt, 2, limit > 0 ? limit : -1);
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        out.push_back({sqlite3_column_int(stmt, 0), sqlite3_column_int(stmt, 1), sqlite3_column_int64(stmt, 2)});
+    }
+    sqlite3_finalize(stmt);
     return rc == SQLITE_DONE;
 }
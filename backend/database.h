@@ -2,30 +2,193 @@
 #define DATABASE_H
 
 #include "recipe.h"
+#include "recipe_cursor.h"
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
 #include <sqlite3.h>
 
-class Database {
+// Inserts many recipes over its own connection with a single reused
+// prepared statement. Rows are queued in memory (at most batchSize of them)
+// and written in one transaction by flush(), so the write lock is only held
+// while rows are actually being inserted, never while the caller is still
+// producing them (e.g. reading a slow upload).
+class BulkInserter {
+public:
+    // Called from flush() for each row a constraint rejected.
+    typedef std::function<void(size_t line, const std::string& error)> RejectHandler;
+
 private:
     sqlite3* db;
+    sqlite3_stmt* stmt;
+    size_t batchSize;
+    std::vector<std::pair<size_t, Recipe>> queued;
+    size_t inserted;
+    bool failed;
+    std::string error;
+    RejectHandler onReject;
+
+    bool exec(const char* sql);
+    bool fail(const std::string& context);
+
+public:
+    // fastLoad skips fsyncs for offline loads (see the constructor).
+    BulkInserter(const std::string& path, size_t batchSize, bool fastLoad = false,
+                 RejectHandler onReject = nullptr);
+    ~BulkInserter();
+    BulkInserter(const BulkInserter&) = delete;
+    BulkInserter& operator=(const BulkInserter&) = delete;
+
+    // False once a database error (not a bad row) has stopped the import.
+    bool ok() const { return !failed; }
+    const std::string& lastError() const { return error; }
+    size_t insertedCount() const { return inserted; }
+    size_t queuedCount() const { return queued.size(); }
+
+    // Queues a row, flushing once batchSize rows are waiting. line is only
+    // passed back to the reject handler. False once the import has failed.
+    bool insert(const Recipe& recipe, size_t line = 0);
+    // Writes the queued rows in one transaction.
+    bool flush();
+    bool finish() { return flush(); }
+};
+
+// Read-only connection that keeps one read transaction open for its
+// lifetime, so everything read through it comes from a single WAL snapshot.
+// Under WAL this never blocks writers; it only holds back checkpoints.
+class SnapshotReader {
+private:
+    sqlite3* db;
+    bool ready;
+
+public:
+    explicit SnapshotReader(const std::string& path);
+    ~SnapshotReader();
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    bool ok() const { return ready; }
+    // Rows with id > afterId in id order; limit <= 0 means all of them.
+    RecipeCursor recipesAfter(int afterId, int limit);
+
+    // Rows and tombstones with change_seq > seq, in change_seq order; at
+    // most limit of each.
+    RecipeCursor changesSince(long long seq, int limit);
+    bool tombstonesSince(long long seq, int limit, std::vector<RecipeTombstone>& out);
+};
+
+// Read-only connections for queries, reused across requests. Queries never
+// run on the connection writes go through: a cursor streaming to a slow
+// client keeps its statement's read transaction open, and under WAL a write
+// from a connection whose snapshot another connection (e.g. a bulk import)
+// has since moved past fails at once with SQLITE_BUSY_SNAPSHOT.
+class ReaderPool : public std::enable_shared_from_this<ReaderPool> {
+private:
+    static const size_t kMaxIdle = 16;
+
+    std::string path;
+    std::mutex mutex;
+    std::vector<sqlite3*> idle;
+
+    void release(sqlite3* connection);
+
+public:
+    explicit ReaderPool(const std::string& path);
+    ~ReaderPool();
+    ReaderPool(const ReaderPool&) = delete;
+    ReaderPool& operator=(const ReaderPool&) = delete;
+
+    // A connection that returns to the pool when the last copy is dropped;
+    // null if one can't be opened. The pool outlives its connections.
+    std::shared_ptr<sqlite3> acquire();
+};
+
+// Told about every row written through Database, after the write
+// succeeded and in commit order, under the write lock. Bulk imports use
+// their own connection; they are reported as one range once numbered.
+class RecipeObserver {
+public:
+    virtual ~RecipeObserver() = default;
+    // Inserted or updated; the row as stored (id and created_at filled in).
+    virtual void recipeStored(const Recipe& recipe) = 0;
+    virtual void recipeDeleted(const RecipeTombstone& tombstone) = 0;
+    // Rows numbered (afterSeq, throughSeq] by sequenceNewRows. No rows are
+    // passed, since there may be millions; read them back if needed, but
+    // not from here, as writes wait meanwhile.
+    virtual void recipesImported(long long afterSeq, long long throughSeq) {}
+};
+
+// change_seq range (after, through] given to a batch of rows.
+struct ChangeRange {
+    long long after = 0;
+    long long through = 0;
+};
+
+class Database {
+private:
+    sqlite3* db;  // writes (and schema setup) only; queries use readers
     std::string db_path;
+    std::shared_ptr<ReaderPool> readers;
+    std::mutex writeMutex;
+    std::vector<RecipeObserver*> observers;
+    long long lastChangeSeq;  // guarded by writeMutex
+
+    bool exec(const std::string& sql);
+    bool tableExists(const std::string& name);
+    int schemaVersion();
+    bool setSchemaVersion(int version);
+    // Prepares a query on a pooled reader; bind, if given, binds the
+    // statement's parameters.
+    RecipeCursor prepareRecipes(const std::string& query,
+                                const std::function<void(sqlite3_stmt*)>& bind = nullptr);
+    bool storeReturning(sqlite3_stmt* stmt);
+    long long maxChangeSeq();
 
 public:
     Database(const std::string& path);
     ~Database();
 
     bool initialize();
-    std::vector<Recipe> getAllRecipes();
-    std::vector<Recipe> filterRecipes(double minProtein, double maxProtein,
+    const std::string& path() const { return db_path; }
+    // change_seq of the latest write (or tombstone) so far.
+    long long latestChangeSeq();
+
+    // Observers must be added before the server starts handling requests.
+    void addObserver(RecipeObserver* observer) { observers.push_back(observer); }
+
+    // Every write through Database takes the next change_seq; a delete
+    // leaves a tombstone with its own. Rows written past it (bulk imports,
+    // older schemas) have change_seq 0 until this numbers them, after
+    // everything sequenced so far, and reports their range to the observers
+    // (and in `numbered`, if given; empty if there were none).
+    bool sequenceNewRows(ChangeRange* numbered = nullptr);
+
+    // Streaming variants of the list queries: rows are decoded on demand and
+    // never copied out of SQLite unless the caller does so.
+    RecipeCursor queryAllRecipes();
+    RecipeCursor queryFilteredRecipes(double minProtein, double maxProtein,
                                       double minCarbs, double maxCarbs,
                                       bool veganOnly, bool vegetarianOnly,
                                       bool glutenFreeOnly);
-    std::vector<Recipe> sortRecipes(const std::string& sortBy, const std::string& order);
+    RecipeCursor querySortedRecipes(const std::string& sortBy, const std::string& order,
+                                    int limit = -1);
+    // The rows with these ids in the given order, in one statement; unknown
+    // ids are skipped.
+    RecipeCursor queryRecipesByIds(const std::vector<int>& ids);
+    // id, created_at, cook_time, difficulty and change_seq of the rows with
+    // change_seq in (afterSeq, throughSeq], oldest first, at most limit.
+    RecipeCursor querySortKeys(long long afterSeq, long long throughSeq, int limit);
+
     Recipe getRecipeById(int id);
     bool addRecipe(const Recipe& recipe);
     bool updateRecipe(int id, const Recipe& recipe);
     bool deleteRecipe(int id);
+    // Deletes every recipe, leaving a tombstone for each in the same
+    // transaction so sync clients see the rows go. Observers aren't told;
+    // it is meant for offline tools (recipe_gen --replace).
+    bool deleteAllRecipes();
 };
 
 #endif
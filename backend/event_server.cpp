@@ -0,0 +1,213 @@
+#include "event_server.h"
+#include "request_queue.h"
+#include <iostream>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+
+const int kMaxEvents = 256;
+const int kSweepIntervalMs = 1000;
+
+std::atomic<size_t> parkedCount(0);
+
+}
+
+EventServer::EventServer(bool eventLoop)
+    : eventLoop(eventLoop), epollFd(-1), wakeFd(-1), stopping(false) {
+    if (!eventLoop) {
+        return;
+    }
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (epollFd < 0 || wakeFd < 0) {
+        std::cerr << "Can't set up epoll, serving one connection per worker" << std::endl;
+        this->eventLoop = false;
+        return;
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+}
+
+EventServer::~EventServer() {
+    stopping = true;
+    if (loopThread.joinable()) {
+        // If the write fails the loop still notices within a sweep interval
+        uint64_t one = 1;
+        ssize_t written = write(wakeFd, &one, sizeof(one));
+        (void)written;
+        loopThread.join();
+    }
+    closeIdle(true);
+    if (wakeFd >= 0) {
+        close(wakeFd);
+    }
+    if (epollFd >= 0) {
+        close(epollFd);
+    }
+}
+
+void EventServer::setDispatcher(std::function<bool(std::function<void()>)> fn) {
+    dispatch = std::move(fn);
+}
+
+size_t EventServer::parkedConnections() {
+    return parkedCount.load(std::memory_order_relaxed);
+}
+
+bool EventServer::process_and_close_socket(socket_t sock) {
+    if (!eventLoop) {
+        // Same as httplib::Server: this worker owns the connection until it closes
+        std::string remoteAddr, localAddr;
+        int remotePort = 0, localPort = 0;
+        httplib::detail::get_remote_ip_and_port(sock, remoteAddr, remotePort);
+        httplib::detail::get_local_ip_and_port(sock, localAddr, localPort);
+        bool ret = httplib::detail::process_server_socket(
+            svr_sock_, sock, keep_alive_max_count_, keep_alive_timeout_sec_,
+            read_timeout_sec_, read_timeout_usec_, write_timeout_sec_, write_timeout_usec_,
+            [&](httplib::Stream& strm, bool closeConnection, bool& connectionClosed) {
+                return process_request(strm, remoteAddr, remotePort, localAddr, localPort,
+                                       closeConnection, connectionClosed, nullptr);
+            });
+        httplib::detail::shutdown_socket(sock);
+        httplib::detail::close_socket(sock);
+        return ret;
+    }
+
+    Connection* conn = new Connection;
+    conn->sock = sock;
+    conn->remaining = keep_alive_max_count_;
+    httplib::detail::get_remote_ip_and_port(sock, conn->remoteAddr, conn->remotePort);
+    httplib::detail::get_local_ip_and_port(sock, conn->localAddr, conn->localPort);
+    serve(conn);
+    return true;
+}
+
+// Serves requests that are already readable, then parks the connection
+// rather than blocking this worker on the next one.
+void EventServer::serve(Connection* conn) {
+    for (;;) {
+        if (svr_sock_ == INVALID_SOCKET) {
+            closeConnection(conn);
+            return;
+        }
+        ssize_t ready = httplib::detail::select_read(conn->sock, 0, 0);
+        if (ready < 0) {
+            closeConnection(conn);
+            return;
+        }
+        if (ready == 0) {
+            park(conn);
+            return;
+        }
+
+        // Requests answered by the overflow threads are 503s; close those
+        // connections so they don't come back through a full queue.
+        bool closeAfter = conn->remaining <= 1 || RequestQueue::overflowing();
+        bool closed = false;
+        httplib::detail::SocketStream strm(conn->sock, read_timeout_sec_, read_timeout_usec_,
+                                           write_timeout_sec_, write_timeout_usec_);
+        bool ok = process_request(strm, conn->remoteAddr, conn->remotePort, conn->localAddr,
+                                  conn->localPort, closeAfter, closed, nullptr);
+        --conn->remaining;
+        if (!ok || closed || closeAfter) {
+            closeConnection(conn);
+            return;
+        }
+    }
+}
+
+void EventServer::park(Connection* conn) {
+    std::call_once(loopStarted, [this] { loopThread = std::thread(&EventServer::runLoop, this); });
+
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+    ev.data.ptr = conn;
+
+    // Registered under the lock so the loop can't see the event (or time
+    // the connection out) before it is in the parked set.
+    std::lock_guard<std::mutex> lock(parkedMutex);
+    conn->idleSince = Clock::now();
+    int op = conn->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    if (epoll_ctl(epollFd, op, conn->sock, &ev) != 0) {
+        closeConnection(conn);
+        return;
+    }
+    conn->registered = true;
+    parked.insert(conn);
+    parkedCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void EventServer::closeConnection(Connection* conn) {
+    if (conn->registered) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, conn->sock, nullptr);
+    }
+    httplib::detail::shutdown_socket(conn->sock);
+    httplib::detail::close_socket(conn->sock);
+    delete conn;
+}
+
+void EventServer::runLoop() {
+    epoll_event events[kMaxEvents];
+    Clock::time_point lastSweep = Clock::now();
+
+    while (!stopping) {
+        int n = epoll_wait(epollFd, events, kMaxEvents, kSweepIntervalMs);
+        if (n < 0 && errno != EINTR) {
+            std::cerr << "epoll_wait failed, closing idle connections" << std::endl;
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            Connection* conn = static_cast<Connection*>(events[i].data.ptr);
+            if (!conn) {
+                uint64_t count;
+                while (read(wakeFd, &count, sizeof(count)) > 0) {
+                }
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lock(parkedMutex);
+                if (parked.erase(conn) == 0) {
+                    continue;
+                }
+                parkedCount.fetch_sub(1, std::memory_order_relaxed);
+            }
+            if (!(events[i].events & EPOLLIN)) {
+                closeConnection(conn);
+                continue;
+            }
+            if (!dispatch) {
+                serve(conn);
+            } else if (!dispatch([this, conn] { serve(conn); })) {
+                closeConnection(conn);
+            }
+        }
+
+        if (svr_sock_ == INVALID_SOCKET) {
+            closeIdle(true);
+        } else if (Clock::now() - lastSweep >= std::chrono::milliseconds(kSweepIntervalMs)) {
+            closeIdle(false);
+            lastSweep = Clock::now();
+        }
+    }
+    closeIdle(true);
+}
+
+// Closes connections idle past the keep-alive timeout, or all of them.
+void EventServer::closeIdle(bool all) {
+    Clock::time_point cutoff = Clock::now() - std::chrono::seconds(keep_alive_timeout_sec_);
+    std::lock_guard<std::mutex> lock(parkedMutex);
+    for (auto it = parked.begin(); it != parked.end();) {
+        Connection* conn = *it;
+        if (all || conn->idleSince < cutoff) {
+            it = parked.erase(it);
+            parkedCount.fetch_sub(1, std::memory_order_relaxed);
+            closeConnection(conn);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef EVENT_SERVER_H
+#define EVENT_SERVER_H
+
+#include "httplib.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+// httplib::Server whose keep-alive connections don't hold a worker while
+// idle. A worker serves whatever requests are ready on a connection, then
+// parks the socket in an epoll loop; when the next request becomes readable
+// the loop hands the connection back to the task queue. Idle connections
+// cost a file descriptor and a few bytes instead of a thread, so the worker
+// pool only has to be sized for requests in flight.
+//
+// With the event loop disabled it behaves like httplib::Server (one worker
+// per connection for its whole life).
+class EventServer : public httplib::Server {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Connection {
+        socket_t sock;
+        std::string remoteAddr;
+        int remotePort = 0;
+        std::string localAddr;
+        int localPort = 0;
+        size_t remaining = 0;     // requests left before keep_alive_max_count
+        Clock::time_point idleSince;
+        bool registered = false;  // added to the epoll set
+    };
+
+    bool eventLoop;
+    std::function<bool(std::function<void()>)> dispatch;
+    int epollFd;
+    int wakeFd;
+    std::thread loopThread;
+    std::once_flag loopStarted;
+    std::atomic<bool> stopping;
+
+    std::mutex parkedMutex;
+    std::unordered_set<Connection*> parked;
+
+    bool process_and_close_socket(socket_t sock) override;
+
+    void serve(Connection* conn);
+    void park(Connection* conn);
+    void closeConnection(Connection* conn);
+    void runLoop();
+    void closeIdle(bool all);
+
+public:
+    explicit EventServer(bool eventLoop);
+    ~EventServer() override;
+    EventServer(const EventServer&) = delete;
+    EventServer& operator=(const EventServer&) = delete;
+
+    // How a readable parked connection gets back onto a worker; normally
+    // the same queue accepted connections go through. Must be set before
+    // listening when the event loop is enabled.
+    void setDispatcher(std::function<bool(std::function<void()>)> fn);
+
+    // Keep-alive connections currently waiting in the event loop.
+    static size_t parkedConnections();
+};
+
+#endif
@@ -0,0 +1,37 @@
+#include "gzip.h"
+#include <cstring>
+
+GzipEncoder::GzipEncoder(int level) : ready(false) {
+    std::memset(&zs, 0, sizeof(zs));
+    // 15 window bits + 16 selects the gzip wrapper instead of zlib's
+    ready = deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+GzipEncoder::~GzipEncoder() {
+    if (ready) {
+        deflateEnd(&zs);
+    }
+}
+
+bool GzipEncoder::compress(const char* data, size_t length, bool finish, std::string& out) {
+    if (!ready) {
+        return false;
+    }
+
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    zs.avail_in = static_cast<uInt>(length);
+
+    char buffer[16 * 1024];
+    int rc;
+    do {
+        zs.next_out = reinterpret_cast<Bytef*>(buffer);
+        zs.avail_out = sizeof(buffer);
+        rc = deflate(&zs, finish ? Z_FINISH : Z_NO_FLUSH);
+        if (rc == Z_STREAM_ERROR) {
+            return false;
+        }
+        out.append(buffer, sizeof(buffer) - zs.avail_out);
+    } while (zs.avail_out == 0 || (finish && rc != Z_STREAM_END));
+
+    return true;
+}
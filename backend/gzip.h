@@ -0,0 +1,25 @@
+#ifndef GZIP_H
+#define GZIP_H
+
+#include <cstddef>
+#include <string>
+#include <zlib.h>
+
+// Incremental gzip (RFC 1952) encoder for chunked responses: each call
+// appends whatever compressed bytes zlib has ready, which may be none.
+class GzipEncoder {
+private:
+    z_stream zs;
+    bool ready;
+
+public:
+    explicit GzipEncoder(int level = Z_DEFAULT_COMPRESSION);
+    ~GzipEncoder();
+    GzipEncoder(const GzipEncoder&) = delete;
+    GzipEncoder& operator=(const GzipEncoder&) = delete;
+
+    // finish writes the gzip trailer; no more input may follow.
+    bool compress(const char* data, size_t length, bool finish, std::string& out);
+};
+
+#endif
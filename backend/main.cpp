@@ -1,111 +1,68 @@
 #include "httplib.h"
+#include "backup.h"
+#include "change_feed.h"
 #include "database.h"
+#include "event_server.h"
+#include "gzip.h"
+#include "metrics.h"
+#include "rate_limiter.h"
 #include "recipe.h"
+#include "recipe_import.h"
+#include "request_queue.h"
+#include "serialize.h"
+#include "server_config.h"
+#include "single_flight.h"
+#include "sorted_lists.h"
+#include "slow_query_log.h"
+#include <algorithm>
+#include <cctype>
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <chrono>
+#include <cstdlib>
 #include <ctime>
 #include <iomanip>
+#include <memory>
+#include <string_view>
+#include <sys/resource.h>
+#include <pthread.h>
+#include <sched.h>
+#include <thread>
+#include <vector>
 
-// Utility function to correctly escape strings for JSON format
-std::string jsonEscape(const std::string &s)
-{
-    std::string escaped = "";
-    for (char c : s)
-    {
-        switch (c)
-        {
-        case '"':
-            escaped += "\\\"";
-            break; // Escape double quotes
-        case '\\':
-            escaped += "\\\\";
-            break; // Escape backslashes
-        case '\b':
-            escaped += "\\b";
-            break; // Escape backspace
-        case '\f':
-            escaped += "\\f";
-            break; // Escape form feed
-        case '\n':
-            escaped += "\\n";
-            break; // ESCAPE THE NEWLINE CHARACTER (THIS FIXES YOUR ERROR)
-        case '\r':
-            escaped += "\\r";
-            break; // Escape carriage return
-        case '\t':
-            escaped += "\\t";
-            break; // Escape tab
-        default:
-            // Only for completeness: handle control characters < 32 (non-printable)
-            if (c >= 0 && c < 32)
-            {
-                std::stringstream ss;
-                ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c;
-                escaped += ss.str();
-            }
-            else
-            {
-                escaped += c;
-            }
-            break;
-        }
-    }
-    return escaped;
-}
-
-std::string recipeToJson(const Recipe &recipe)
-{
-    std::stringstream ss;
-    ss << "{";
-    ss << "\"id\":" << recipe.id << ",";
-    ss << "\"title\":\"" << jsonEscape(recipe.title) << "\",";             // Applied escaping
-    ss << "\"description\":\"" << jsonEscape(recipe.description) << "\","; // Applied escaping
-    ss << "\"image_url\":\"" << jsonEscape(recipe.image_url) << "\",";     // Applied escaping
-    ss << "\"protein\":" << recipe.protein << ",";
-    ss << "\"carbs\":" << recipe.carbs << ",";
-    ss << "\"is_vegan\":" << (recipe.is_vegan ? "true" : "false") << ",";
-    ss << "\"is_vegetarian\":" << (recipe.is_vegetarian ? "true" : "false") << ",";
-    ss << "\"is_gluten_free\":" << (recipe.is_gluten_free ? "true" : "false") << ",";
-    ss << "\"cook_time\":" << recipe.cook_time << ",";
-    ss << "\"difficulty\":\"" << jsonEscape(recipe.difficulty) << "\",";     // Applied escaping
-    ss << "\"ingredients\":\"" << jsonEscape(recipe.ingredients) << "\",";   // Applied escaping
-    ss << "\"instructions\":\"" << jsonEscape(recipe.instructions) << "\","; // Applied escaping
-    ss << "\"created_at\":\"" << jsonEscape(recipe.created_at) << "\"";      // Applied escaping
-    ss << "}";
-    return ss.str();
-}
-
-std::string recipesToJson(const std::vector<Recipe> &recipes)
+std::string getQueryParam(const httplib::Request &req, const std::string &key, const std::string &defaultValue = "")
 {
-    std::stringstream ss;
-    ss << "[";
-    for (size_t i = 0; i < recipes.size(); ++i)
+    if (req.has_param(key))
     {
-        ss << recipeToJson(recipes[i]);
-        if (i < recipes.size() - 1)
-            ss << ",";
+        return req.get_param_value(key);
     }
-    ss << "]";
-    return ss.str();
+    return defaultValue;
 }
 
-std::string getQueryParam(const httplib::Request &req, const std::string &key, const std::string &defaultValue = "")
+double getQueryParamDouble(const httplib::Request &req, const std::string &key, double defaultValue = -1.0)
 {
     if (req.has_param(key))
     {
-        return req.get_param_value(key);
+        try
+        {
+            return std::stod(req.get_param_value(key));
+        }
+        catch (...)
+        {
+            return defaultValue;
+        }
     }
     return defaultValue;
 }
 
-double getQueryParamDouble(const httplib::Request &req, const std::string &key, double defaultValue = -1.0)
+int getQueryParamInt(const httplib::Request &req, const std::string &key, int defaultValue = -1)
 {
     if (req.has_param(key))
     {
         try
         {
-            return std::stod(req.get_param_value(key));
+            return std::stoi(req.get_param_value(key));
         }
         catch (...)
         {
@@ -125,76 +82,533 @@ bool getQueryParamBool(const httplib::Request &req, const std::string &key)
     return false;
 }
 
-// // Add this helper function somewhere in main.cpp, perhaps before recipeToJson
-// std::string jsonEscape(const std::string &s)
-// {
-//     std::string escaped = "";
-//     for (char c : s)
-//     {
-//         switch (c)
-//         {
-//         case '"':
-//             escaped += "\\\"";
-//             break;
-//         case '\\':
-//             escaped += "\\\\";
-//             break;
-//         case '\b':
-//             escaped += "\\b";
-//             break;
-//         case '\f':
-//             escaped += "\\f";
-//             break;
-//         case '\n':
-//             escaped += "\\n";
-//             break;
-//         case '\r':
-//             escaped += "\\r";
-//             break;
-//         case '\t':
-//             escaped += "\\t";
-//             break;
-//         default:
-//             if (c < 32 || c > 126)
-//             { // Handle other control characters (optional but good practice)
-//                 std::stringstream ss;
-//                 ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c;
-//                 escaped += ss.str();
-//             }
-//             else
-//             {
-//                 escaped += c;
-//             }
-//             break;
-//         }
-//     }
-//     return escaped;
-// }
-
-int main()
+// Rows are buffered until a chunk reaches this size before being handed to
+// the socket; the buffer is reused, so memory per stream stays constant.
+const size_t kStreamChunkBytes = 16 * 1024;
+
+// Largest unfiltered ?limit= still admitted without an expensive slot.
+const int kCheapListLimit = 1000;
+
+// Most ids one /api/recipes/batch request may ask for.
+const size_t kBatchMaxIds = 1000;
+
+// Changes per /api/recipes/sync page: the default, and the most ?limit= may ask for.
+const int kSyncPageRows = 1000;
+const int kSyncMaxPageRows = 10000;
+
+// Bulk import rows queued in memory before they are written (?batch= may ask
+// for fewer), and how long a partial batch may wait for more of the upload.
+const int kBulkMaxBatch = 10000;
+const auto kBulkFlushInterval = std::chrono::milliseconds(100);
+
+struct StreamOptions
 {
-    Database db("recipes.db");
-    if (!db.initialize())
+    // Compress here with Content-Encoding: gzip (httplib is built without
+    // zlib support, so it never compresses on its own)
+    bool gzip = false;
+    // Stop after this many rows; 0 streams the whole cursor
+    size_t maxRows = 0;
+    // Send X-Export-Cursor (last id written) and X-Export-Complete as
+    // chunked trailers so an interrupted or paged export can resume
+    bool exportTrailers = false;
+    // Anything the cursor depends on, such as its snapshot connection
+    std::shared_ptr<void> owner;
+};
+
+// Streams the cursor's rows as a chunked list in the serializer's format.
+// httplib only calls the provider again once the socket is writable, so a
+// slow client throttles how fast rows are stepped out of SQLite instead of
+// piling up in memory.
+template <typename Cursor>
+void streamRecipes(httplib::Response &res, Cursor cursor, const RecipeSerializer &serializer,
+                   StreamOptions options = StreamOptions())
+{
+    // Step to the first row before committing to a 200: a query that fails
+    // up front (prepare or first step) is still a plain error response.
+    bool primed = cursor.next();
+    if (!primed && !cursor.ok())
     {
-        std::cerr << "Failed to initialize database" << std::endl;
-        return 1;
+        res.status = 500;
+        res.set_content("{\"error\":\"Failed to load recipes\"}", "application/json");
+        return;
+    }
+
+    struct StreamState
+    {
+        StreamOptions options;
+        Cursor cursor;
+        bool primed = false; // cursor.row() holds a row not yet written
+        std::unique_ptr<GzipEncoder> gzip;
+        std::string chunk;
+        std::string compressed;
+        bool started = false;
+        size_t rows = 0;
+        int lastId = 0;
+        bool complete = true;
+    };
+    auto state = std::make_shared<StreamState>();
+    state->options = std::move(options);
+    state->cursor = std::move(cursor);
+    state->primed = primed;
+    state->chunk.reserve(kStreamChunkBytes + 4096);
+    if (state->options.gzip)
+    {
+        state->gzip.reset(new GzipEncoder());
+        res.set_header("Content-Encoding", "gzip");
+    }
+    // Most of a stream's work happens after the headers are out, so the
+    // full timing breakdown follows as a trailer.
+    res.set_header("Trailer", state->options.exportTrailers ? "Server-Timing, X-Export-Cursor, X-Export-Complete"
+                                                            : "Server-Timing");
+
+    res.set_chunked_content_provider(serializer.contentType(), [state, &serializer](size_t, httplib::DataSink &sink)
+                                     {
+        std::string &chunk = state->chunk;
+        chunk.clear();
+        if (!state->started) {
+            serializer.beginList(chunk);
+        }
+
+        auto flush = [&](bool last) {
+            std::string *out = &chunk;
+            if (state->gzip) {
+                state->compressed.clear();
+                if (!state->gzip->compress(chunk.data(), chunk.size(), last, state->compressed)) {
+                    return false;
+                }
+                out = &state->compressed;
+            }
+            Metrics::addStreamedBytes(out->size());
+            PhaseTimer timer(Metrics::PhaseWrite);
+            return out->empty() || sink.write(out->data(), out->size());
+        };
+
+        auto nextRow = [&] {
+            if (state->primed) {
+                state->primed = false;
+                return true;
+            }
+            return state->cursor.next();
+        };
+
+        while (nextRow()) {
+            if (state->options.maxRows > 0 && state->rows == state->options.maxRows) {
+                state->complete = false;
+                break;
+            }
+            {
+                PhaseTimer timer(Metrics::PhaseSerialize);
+                serializer.appendItem(chunk, state->cursor.row(), !state->started);
+            }
+            state->lastId = state->cursor.row().id;
+            ++state->rows;
+
+            // Flush right after the first row so time-to-first-byte doesn't
+            // wait for a full chunk.
+            bool first = !state->started;
+            state->started = true;
+            if (first || chunk.size() >= kStreamChunkBytes) {
+                return flush(false);
+            }
+        }
+
+        // A failed step mid-stream can't change the status any more; abort
+        // so the client sees a truncated response rather than a valid list.
+        if (!state->cursor.ok()) {
+            return false;
+        }
+
+        state->started = true;
+        serializer.endList(chunk);
+        if (!flush(true)) {
+            return false;
+        }
+        httplib::Headers trailer = {{"Server-Timing", Metrics::serverTiming(Metrics::currentTiming())}};
+        if (state->options.exportTrailers) {
+            trailer.emplace("X-Export-Cursor", std::to_string(state->lastId));
+            trailer.emplace("X-Export-Complete", state->complete ? "true" : "false");
+        }
+        sink.done_with_trailer(trailer);
+        return true; });
+}
+
+// Largest list body buffered for sharing between identical requests; a
+// bigger one is streamed to each of them instead.
+const size_t kMaxSharedListBytes = 4 * 1024 * 1024;
+
+// renderList's result when the list outgrew maxBytes.
+const SingleFlight::Result kListTooLarge = std::make_shared<const std::string>();
+
+// Serializes a whole list into one buffer that concurrent identical
+// requests can share; null if a step failed, kListTooLarge once the body
+// passes maxBytes (0 = no limit).
+template <typename Cursor>
+SingleFlight::Result renderList(Cursor cursor, const RecipeSerializer &serializer, size_t maxBytes = 0)
+{
+    auto body = std::make_shared<std::string>();
+    serializer.beginList(*body);
+    bool first = true;
+    while (cursor.next())
+    {
+        PhaseTimer timer(Metrics::PhaseSerialize);
+        serializer.appendItem(*body, cursor.row(), first);
+        first = false;
+        if (maxBytes > 0 && body->size() > maxBytes)
+            return kListTooLarge;
+    }
+    if (!cursor.ok())
+        return nullptr;
+    serializer.endList(*body);
+    return body;
+}
+
+// Sends a shared buffer without copying it into the response.
+void sendShared(httplib::Response &res, SingleFlight::Result body, const char *contentType)
+{
+    res.set_content_provider(body->size(), contentType,
+                             [body](size_t offset, size_t length, httplib::DataSink &sink)
+                             {
+                                 PhaseTimer timer(Metrics::PhaseWrite);
+                                 return sink.write(body->data() + offset, length);
+                             });
+}
+
+// Identifies a list request: the response format plus every query
+// parameter (httplib keeps them sorted by name).
+std::string listQueryKey(const httplib::Request &req, const RecipeSerializer &serializer)
+{
+    std::string key = serializer.contentType();
+    for (const auto &param : req.params)
+    {
+        key += '\n';
+        key += param.first;
+        key += '=';
+        key += param.second;
+    }
+    return key;
+}
+
+// JSON unless the client's Accept header asks for NDJSON or CBOR
+const RecipeSerializer &negotiateSerializer(const httplib::Request &req, httplib::Response &res)
+{
+    res.set_header("Vary", "Accept");
+    return serializerFor(negotiateRecipeFormat(req.get_header_value("Accept")));
+}
+
+// The handler pattern a recipe API path will be routed to, for requests
+// classified before routing has set matched_route.
+std::string routePattern(const std::string &path)
+{
+    const std::string prefix = "/api/recipes";
+    if (path.compare(0, prefix.size(), prefix) != 0)
+        return "";
+    if (path.size() == prefix.size() || path == "/api/recipes/bulk" || path == "/api/recipes/export" ||
+        path == "/api/recipes/changes" || path == "/api/recipes/sync" || path == "/api/recipes/batch")
+        return path;
+    if (path[prefix.size()] == '/' && path.size() > prefix.size() + 1 &&
+        path.find('/', prefix.size() + 1) == std::string::npos)
+        return "/api/recipes/:id";
+    return "";
+}
+
+Metrics::Route classifyRoute(const httplib::Request &req)
+{
+    const std::string route = req.matched_route.empty() ? routePattern(req.path) : req.matched_route;
+    const std::string &method = req.method;
+
+    if (route == "/api/recipes")
+    {
+        if (method == "GET")
+            return Metrics::RouteList;
+        if (method == "POST")
+            return Metrics::RouteCreate;
+    }
+    else if (route == "/api/recipes/:id")
+    {
+        if (method == "GET")
+            return Metrics::RouteGet;
+        if (method == "PUT")
+            return Metrics::RouteUpdate;
+        if (method == "DELETE")
+            return Metrics::RouteDelete;
+    }
+    else if (route == "/api/recipes/bulk" && method == "POST")
+    {
+        return Metrics::RouteBulk;
+    }
+    else if (route == "/api/recipes/export")
+    {
+        return Metrics::RouteExport;
+    }
+    else if (route == "/api/recipes/changes" && method == "GET")
+    {
+        return Metrics::RouteChanges;
+    }
+    else if (route == "/api/recipes/sync" && method == "GET")
+    {
+        return Metrics::RouteSync;
+    }
+    else if (route == "/api/recipes/batch" && (method == "GET" || method == "POST"))
+    {
+        return Metrics::RouteBatch;
+    }
+    else if (route.empty() && (method == "GET" || method == "HEAD") && req.path.rfind("/api/", 0) != 0)
+    {
+        // Served from a mount point (no handler matched)
+        return Metrics::RouteStatic;
+    }
+    return Metrics::RouteOther;
+}
+
+// Body bytes of a non-streamed response; streamed bytes are counted as they
+// are written.
+uint64_t responseBodyBytes(const httplib::Response &res)
+{
+    if (!res.body.empty())
+        return res.body.size();
+    try
+    {
+        return std::stoull(res.get_header_value("Content-Length", "0"));
+    }
+    catch (...)
+    {
+        return 0;
+    }
+}
+
+// Cheap requests are served even under load; expensive ones need a slot.
+// Top-K pages (a limit up to kCheapListLimit, without filters) stay cheap:
+// they read a few index entries. A larger limit is as costly as the full
+// list.
+bool isExpensive(const httplib::Request &req)
+{
+    if (req.path == "/api/recipes/export" || req.path == "/api/recipes/bulk")
+        return true;
+    if (req.path != "/api/recipes" || req.method != "GET")
+        return false;
+    bool hasFilters = req.has_param("minProtein") || req.has_param("maxProtein") ||
+                      req.has_param("minCarbs") || req.has_param("maxCarbs") ||
+                      req.has_param("vegan") || req.has_param("vegetarian") ||
+                      req.has_param("glutenFree");
+    int limit = getQueryParamInt(req, "limit");
+    return hasFilters || limit <= 0 || limit > kCheapListLimit;
+}
+
+void rejectBusy(httplib::Response &res, int retryAfterSeconds)
+{
+    res.status = 503;
+    res.set_header("Retry-After", std::to_string(retryAfterSeconds));
+    res.set_header("Access-Control-Allow-Origin", "*");
+    res.set_content("{\"error\":\"Server busy, retry later\"}", "application/json");
+}
+
+// Adapts RequestQueue to cpp-httplib's TaskQueue interface.
+class ServerTaskQueue : public httplib::TaskQueue
+{
+private:
+    RequestQueue queue;
+
+public:
+    explicit ServerTaskQueue(const RequestQueueSettings &settings) : queue(settings) {}
+
+    bool enqueue(std::function<void()> fn) override
+    {
+        if (!queue.enqueue(std::move(fn)))
+        {
+            Metrics::addRejection(Metrics::RejectDropped);
+            return false;
+        }
+        return true;
+    }
+    void shutdown() override { queue.shutdown(); }
+};
+
+// One accept loop with its own SO_REUSEPORT socket, task queue and workers.
+struct Listener
+{
+    EventServer server;
+    ServerTaskQueue *taskQueue = nullptr;
+    socket_t socket = INVALID_SOCKET;
+    std::vector<int> cpus;
+
+    explicit Listener(bool eventLoop) : server(eventLoop) {}
+};
+
+// The CPUs this process may run on, split into `parts` contiguous groups
+// (or shared round-robin when there are fewer CPUs than parts).
+std::vector<std::vector<int>> splitCpus(int parts)
+{
+    std::vector<std::vector<int>> groups(parts);
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        return groups;
+
+    std::vector<int> cpus;
+    for (int c = 0; c < CPU_SETSIZE; ++c)
+        if (CPU_ISSET(c, &allowed))
+            cpus.push_back(c);
+    if (cpus.empty())
+        return groups;
+
+    if (cpus.size() >= static_cast<size_t>(parts))
+    {
+        for (size_t k = 0; k < cpus.size(); ++k)
+            groups[k * parts / cpus.size()].push_back(cpus[k]);
+    }
+    else
+    {
+        for (int i = 0; i < parts; ++i)
+            groups[i].push_back(cpus[i % cpus.size()]);
     }
+    return groups;
+}
 
-    httplib::Server svr;
+// Threads started from here on (the listener's workers and event loop)
+// inherit the mask.
+void pinCurrentThread(const std::vector<int> &cpus)
+{
+    if (cpus.empty())
+        return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : cpus)
+        CPU_SET(c, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// Installs the request hooks and every route on one listener. With several
+// listeners each gets its own copy; they share everything else.
+void registerRoutes(httplib::Server &svr, const ServerConfig &config, Database &db, BackupManager &backups,
+                    ExpensiveGate &expensiveGate, RateLimiter &rateLimiter, SingleFlight &listFlights,
+                    SortedLists &sortedLists, ChangeFeed &changeFeed)
+{
+    // Every request is timed from routing until its last byte is written
+    // (the logger runs after the response has gone out).
+    // Load shedding happens here too, before any routing work.
+    svr.set_pre_routing_handler([&](const httplib::Request &req, httplib::Response &res)
+                                {
+        Metrics::beginRequest();
+        auto queued = RequestQueue::takeQueueTime();
+        Metrics::addPhaseTime(Metrics::PhaseQueue, queued);
+
+        int retryAfter = 0;
+        if (!rateLimiter.admit(req.remote_addr, classifyRoute(req), retryAfter)) {
+            res.status = 429;
+            res.set_header("Retry-After", std::to_string(retryAfter));
+            res.set_header("Access-Control-Allow-Origin", "*");
+            res.set_content("{\"error\":\"Too many requests\"}", "application/json");
+            return httplib::Server::HandlerResponse::Handled;
+        }
+
+        if (RequestQueue::overflowing()) {
+            Metrics::addRejection(Metrics::RejectQueueFull);
+            rejectBusy(res, config.retryAfterSeconds);
+            res.set_header("Connection", "close");
+            return httplib::Server::HandlerResponse::Handled;
+        }
+        // Shed on the wait itself, not just the queue length: a short queue
+        // of slow requests can still hold connections past their clients'
+        // timeouts, and serving those is wasted work.
+        if (config.maxQueueWaitMs > 0 && queued > std::chrono::milliseconds(config.maxQueueWaitMs)) {
+            Metrics::addRejection(Metrics::RejectQueueWait);
+            rejectBusy(res, config.retryAfterSeconds);
+            return httplib::Server::HandlerResponse::Handled;
+        }
+        if (isExpensive(req)) {
+            PhaseTimer timer(Metrics::PhaseQueue);
+            if (!expensiveGate.enter(std::chrono::milliseconds(config.expensiveWaitMs))) {
+                Metrics::addRejection(Metrics::RejectBusy);
+                rejectBusy(res, config.retryAfterSeconds);
+                return httplib::Server::HandlerResponse::Handled;
+            }
+        }
+        return httplib::Server::HandlerResponse::Unhandled; });
+    // Phase breakdown as a Server-Timing header once the handler is done.
+    svr.set_post_routing_handler([](const httplib::Request &, httplib::Response &res)
+                                 {
+        res.set_header("Access-Control-Expose-Headers", "Server-Timing");
+        res.set_header("Timing-Allow-Origin", "*");
+        res.set_header("Server-Timing", Metrics::serverTiming(Metrics::currentTiming())); });
+
+    // timing_log prints one logfmt line per request with the same
+    // breakdown, measured after the last byte was written.
+    bool timingLog = config.timingLog;
+    svr.set_logger([timingLog](const httplib::Request &req, const httplib::Response &res)
+                   {
+        ExpensiveGate::releaseHeld();
+        Metrics::Route route = classifyRoute(req);
+        Metrics::RequestTiming timing = Metrics::currentTiming();
+        Metrics::endRequest(route, res.status, responseBodyBytes(res));
+        if (!timingLog)
+            return;
+
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(3)
+             << "method=" << req.method << " path=" << req.path << " route=" << Metrics::routeName(route)
+             << " status=" << res.status << " total_ms=" << timing.totalMs;
+        for (int p = 0; p < Metrics::PhaseCount; ++p)
+            line << " " << Metrics::phaseName(static_cast<Metrics::Phase>(p)) << "_ms=" << timing.phaseMs[p];
+        line << "\n";
+        std::cout << line.str() << std::flush; });
 
     svr.set_mount_point("/", "../frontend");
     svr.set_mount_point("/uploads", "../uploads");
 
+    // Filtered and top-K lists are what popular pages load all at once, so
+    // identical concurrent requests share one query and one response buffer,
+    // as long as it stays under kMaxSharedListBytes; larger lists and the
+    // unfiltered catalog stream instead. With the in-memory sorted lists
+    // enabled, a sorted page's ids come from memory and its rows from one
+    // primary-key lookup each.
     svr.Get("/api/recipes", [&](const httplib::Request &req, httplib::Response &res)
             {
-        std::vector<Recipe> recipes;
-
         bool hasFilters = req.has_param("minProtein") || req.has_param("maxProtein") ||
                           req.has_param("minCarbs") || req.has_param("maxCarbs") ||
                           req.has_param("vegan") || req.has_param("vegetarian") ||
                           req.has_param("glutenFree");
 
         bool hasSorting = req.has_param("sortBy");
+        int limit = getQueryParamInt(req, "limit");
+
+        res.set_header("Access-Control-Allow-Origin", "*");
+        const RecipeSerializer &serializer = negotiateSerializer(req, res);
+
+        if (!hasFilters && !hasSorting && limit <= 0) {
+            streamRecipes(res, db.queryAllRecipes(), serializer);
+            return;
+        }
+
+        // open() runs the query; it runs again to stream a list that turned
+        // out too large to share.
+        auto respond = [&](auto open) {
+            bool leader = false;
+            // Followers don't run the query, so they hand back their
+            // expensive-request slot while they wait.
+            SingleFlight::Result body = listFlights.run(
+                listQueryKey(req, serializer),
+                [&]() -> SingleFlight::Result {
+                    leader = true;
+                    return renderList(open(), serializer, kMaxSharedListBytes);
+                },
+                ExpensiveGate::releaseHeld);
+            if (body == kListTooLarge) {
+                if (!leader && isExpensive(req) &&
+                    !expensiveGate.enter(std::chrono::milliseconds(config.expensiveWaitMs))) {
+                    Metrics::addRejection(Metrics::RejectBusy);
+                    rejectBusy(res, config.retryAfterSeconds);
+                    return;
+                }
+                streamRecipes(res, open(), serializer);
+                return;
+            }
+            if (!body) {
+                res.status = 500;
+                res.set_content("{\"error\":\"Failed to load recipes\"}", "application/json");
+                return;
+            }
+            sendShared(res, body, serializer.contentType());
+        };
 
         if (hasFilters) {
             double minProtein = getQueryParamDouble(req, "minProtein");
@@ -204,19 +618,250 @@ int main()
             bool vegan = getQueryParamBool(req, "vegan");
             bool vegetarian = getQueryParamBool(req, "vegetarian");
             bool glutenFree = getQueryParamBool(req, "glutenFree");
+            respond([&] {
+                return db.queryFilteredRecipes(minProtein, maxProtein, minCarbs, maxCarbs,
+                                               vegan, vegetarian, glutenFree);
+            });
+            return;
+        }
+        // Top-K: only the first `limit` rows are read and serialized
+        std::string sortBy = getQueryParam(req, "sortBy", "created_at");
+        std::string order = getQueryParam(req, "order", "desc");
+        // The in-memory orders only serve pages small enough to pass as one
+        // id list; longer or unlimited lists stream from SQLite.
+        if (sortedLists.enabled() && limit > 0 && limit <= kCheapListLimit)
+            respond([&] { return db.queryRecipesByIds(sortedLists.sorted(sortBy, order, limit)); });
+        else
+            respond([&] { return db.querySortedRecipes(sortBy, order, limit); }); });
 
-            recipes = db.filterRecipes(minProtein, maxProtein, minCarbs, maxCarbs,
-                                       vegan, vegetarian, glutenFree);
-        } else if (hasSorting) {
-            std::string sortBy = getQueryParam(req, "sortBy", "created_at");
-            std::string order = getQueryParam(req, "order", "desc");
-            recipes = db.sortRecipes(sortBy, order);
-        } else {
-            recipes = db.getAllRecipes();
+    // Full-catalog dump in id order (NDJSON by default; ?format=csv|json|cbor),
+    // read from a snapshot connection so it never blocks writers. Resume or
+    // page with ?after=<X-Export-Cursor>&limit=N; gzip with
+    // Accept-Encoding: gzip or ?gzip=1.
+    svr.Get("/api/recipes/export", [&](const httplib::Request &req, httplib::Response &res)
+            {
+        res.set_header("Access-Control-Allow-Origin", "*");
+
+        RecipeFormat format = RecipeFormat::Ndjson;
+        if (req.has_param("format") && !parseRecipeFormat(req.get_param_value("format"), format)) {
+            res.status = 400;
+            res.set_content("{\"error\":\"Unknown format\"}", "application/json");
+            return;
+        }
+
+        auto snapshot = std::make_shared<SnapshotReader>(db.path());
+        if (!snapshot->ok()) {
+            res.status = 500;
+            res.set_content("{\"error\":\"Failed to open snapshot\"}", "application/json");
+            return;
+        }
+
+        StreamOptions options;
+        options.gzip = getQueryParamBool(req, "gzip") ||
+                       req.get_header_value("Accept-Encoding").find("gzip") != std::string::npos;
+        options.exportTrailers = true;
+        int limit = getQueryParamInt(req, "limit", 0);
+        if (limit > 0) {
+            // One extra row tells us whether the export is complete
+            options.maxRows = limit;
+            limit += 1;
+        }
+        RecipeCursor cursor = snapshot->recipesAfter(getQueryParamInt(req, "after", 0), limit);
+        options.owner = snapshot;
+
+        streamRecipes(res, std::move(cursor), serializerFor(format), std::move(options)); });
+
+    // Server-Sent Events for every create, update and delete, each with the
+    // row's version and change seq (and body, unless deleted). A bulk import
+    // is one "resync" event with the seq range it added ({"after","through"});
+    // clients fetch those rows through /api/recipes/sync. Event ids are
+    // change seqs, so a client reconnecting with Last-Event-ID (or ?since=)
+    // resumes after that change, across server restarts too. If the changes
+    // after it are no longer in the ring it gets a "reset" event and should
+    // catch up through /api/recipes/sync from the last seq it saw; the reset's
+    // id is the seq the stream continues after.
+    svr.Get("/api/recipes/changes", [&](const httplib::Request &req, httplib::Response &res)
+            {
+        res.set_header("Access-Control-Allow-Origin", "*");
+        if (!changeFeed.attach(config.changeFeedMaxClients)) {
+            Metrics::addRejection(Metrics::RejectBusy);
+            rejectBusy(res, config.retryAfterSeconds);
+            return;
+        }
+
+        struct FeedState
+        {
+            uint64_t next = 0;
+            bool started = false;
+            bool reset = false;
+            uint64_t resetSeq = 0;  // id of the reset event
+            std::string frame;
+            std::string chunk;
+        };
+        auto state = std::make_shared<FeedState>();
+        state->next = changeFeed.latest() + 1;
+        std::string resume = req.get_header_value("Last-Event-ID");
+        if (resume.empty())
+            resume = getQueryParam(req, "since");
+        if (!resume.empty()) {
+            uint64_t position = 0;
+            try {
+                position = changeFeed.positionAfter(std::stoull(resume));
+            } catch (...) {
+            }
+            if (position > 0) {
+                state->next = position;
+            } else {
+                // Position first: the seq read after it is at least as new
+                state->next = changeFeed.latest() + 1;
+                state->resetSeq = changeFeed.latestChangeSeq();
+                state->reset = true;
+            }
+        }
+
+        res.set_header("Cache-Control", "no-cache");
+        res.set_chunked_content_provider(
+            "text/event-stream",
+            [state, &changeFeed](size_t, httplib::DataSink &sink)
+            {
+                std::string &chunk = state->chunk;
+                chunk.clear();
+                if (!state->started) {
+                    state->started = true;
+                    chunk += "retry: 2000\n\n";
+                }
+                for (;;) {
+                    if (state->reset) {
+                        chunk += "id: " + std::to_string(state->resetSeq) + "\nevent: reset\ndata: {}\n\n";
+                        state->reset = false;
+                    }
+                    ChangeFeed::ReadResult result = changeFeed.read(state->next, state->frame);
+                    if (result == ChangeFeed::Overrun) {
+                        changeFeed.countOverrun();
+                        state->next = changeFeed.latest() + 1;
+                        state->resetSeq = changeFeed.latestChangeSeq();
+                        state->reset = true;
+                        continue;
+                    }
+                    if (result == ChangeFeed::Pending)
+                        break;
+                    chunk += state->frame;
+                    ++state->next;
+                    if (chunk.size() >= kStreamChunkBytes)
+                        break;
+                }
+
+                // Nothing new: sleep until there is, with a comment line as
+                // heartbeat so proxies and dead clients are noticed.
+                if (chunk.empty()) {
+                    changeFeed.waitAfter(state->next - 1, std::chrono::seconds(15));
+                    if (changeFeed.latest() >= state->next)
+                        return true;
+                    chunk = ": keep-alive\n\n";
+                }
+                Metrics::addStreamedBytes(chunk.size());
+                PhaseTimer timer(Metrics::PhaseWrite);
+                return sink.write(chunk.data(), chunk.size());
+            },
+            [&changeFeed](bool) { changeFeed.detach(); }); });
+
+    // Many recipes by id in one round trip: GET ?ids=1,2,3, or POST with the
+    // list as the body (for lists too long for a URL). Rows come back in the
+    // requested order, from a single statement; unknown ids are left out.
+    auto serveBatch = [&db](const std::string &idList, const httplib::Request &req, httplib::Response &res)
+    {
+        res.set_header("Access-Control-Allow-Origin", "*");
+        std::vector<int> ids;
+        if (!parseIdList(idList, ids) || ids.empty() || ids.size() > kBatchMaxIds) {
+            res.status = 400;
+            res.set_content("{\"error\":\"Expected 1 to " + std::to_string(kBatchMaxIds) + " comma-separated ids\"}",
+                            "application/json");
+            return;
+        }
+
+        const RecipeSerializer &serializer = negotiateSerializer(req, res);
+        SingleFlight::Result body = renderList(db.queryRecipesByIds(ids), serializer);
+        if (!body) {
+            res.status = 500;
+            res.set_content("{\"error\":\"Failed to load recipes\"}", "application/json");
+            return;
         }
+        sendShared(res, body, serializer.contentType());
+    };
+    svr.Get("/api/recipes/batch", [serveBatch](const httplib::Request &req, httplib::Response &res)
+            { serveBatch(req.get_param_value("ids"), req, res); });
+    svr.Post("/api/recipes/batch", [serveBatch](const httplib::Request &req, httplib::Response &res)
+             { serveBatch(req.body, req, res); });
 
+    // Delta sync: rows and tombstones changed after ?since=<seq>, oldest
+    // first, at most ?limit= per page. Clients store `next` and ask again
+    // while `more` is true; since=0 pages through the whole catalog. Rows
+    // and tombstones are read from one snapshot, so a page is consistent.
+    svr.Get("/api/recipes/sync", [&](const httplib::Request &req, httplib::Response &res)
+            {
         res.set_header("Access-Control-Allow-Origin", "*");
-        res.set_content(recipesToJson(recipes), "application/json"); });
+        long long since = 0;
+        try {
+            since = std::stoll(getQueryParam(req, "since", "0"));
+        } catch (...) {
+            res.status = 400;
+            res.set_content("{\"error\":\"since must be a change seq\"}", "application/json");
+            return;
+        }
+        int limit = getQueryParamInt(req, "limit", kSyncPageRows);
+        if (limit <= 0)
+            limit = kSyncPageRows;
+        limit = std::min(limit, kSyncMaxPageRows);
+
+        // One extra of each tells us whether another page follows
+        SnapshotReader snapshot(db.path());
+        RecipeCursor rows = snapshot.changesSince(since, limit + 1);
+        std::vector<RecipeTombstone> tombstones;
+        if (!snapshot.ok() || !snapshot.tombstonesSince(since, limit + 1, tombstones)) {
+            res.status = 500;
+            res.set_content("{\"error\":\"Failed to read changes\"}", "application/json");
+            return;
+        }
+
+        std::string changes;
+        long long next = since;
+        int count = 0;
+        size_t t = 0;
+        bool haveRow = rows.next();
+        {
+            PhaseTimer timer(Metrics::PhaseSerialize);
+            for (; count < limit && (haveRow || t < tombstones.size()); ++count) {
+                if (count > 0)
+                    changes += ',';
+                if (haveRow && (t == tombstones.size() || rows.row().change_seq < tombstones[t].change_seq)) {
+                    const RecipeView &row = rows.row();
+                    next = row.change_seq;
+                    changes += "{\"seq\":" + std::to_string(row.change_seq) + ",\"id\":" + std::to_string(row.id) +
+                               ",\"version\":" + std::to_string(row.version) + ",\"recipe\":";
+                    appendRecipeJson(changes, row);
+                    changes += '}';
+                    haveRow = rows.next();
+                } else {
+                    const RecipeTombstone &tombstone = tombstones[t++];
+                    next = tombstone.change_seq;
+                    changes += "{\"seq\":" + std::to_string(tombstone.change_seq) + ",\"id\":" +
+                               std::to_string(tombstone.id) + ",\"version\":" + std::to_string(tombstone.version) +
+                               ",\"deleted\":true}";
+                }
+            }
+        }
+        if (!rows.ok()) {
+            res.status = 500;
+            res.set_content("{\"error\":\"Failed to read changes\"}", "application/json");
+            return;
+        }
+
+        bool more = haveRow || t < tombstones.size();
+        std::string body = "{\"since\":" + std::to_string(since) + ",\"next\":" + std::to_string(next) +
+                           ",\"more\":" + (more ? "true" : "false") + ",\"changes\":[";
+        body += changes;
+        body += "]}";
+        res.set_content(std::move(body), "application/json"); });
 
     svr.Get("/api/recipes/:id", [&](const httplib::Request &req, httplib::Response &res)
             {
@@ -229,7 +874,13 @@ int main()
             res.status = 404;
             res.set_content("{\"error\":\"Recipe not found\"}", "application/json");
         } else {
-            res.set_content(recipeToJson(recipe), "application/json");
+            const RecipeSerializer &serializer = negotiateSerializer(req, res);
+            std::string body;
+            {
+                PhaseTimer timer(Metrics::PhaseSerialize);
+                serializer.appendRecipe(body, viewOf(recipe));
+            }
+            res.set_content(std::move(body), serializer.contentType());
         } });
 
     svr.Post("/api/recipes", [&](const httplib::Request &req, httplib::Response &res)
@@ -260,7 +911,7 @@ int main()
         recipe.is_vegetarian = req.form.get_field("is_vegetarian") == "1";
         recipe.is_gluten_free = req.form.get_field("is_gluten_free") == "1";
         recipe.cook_time = std::stoi(req.form.get_field("cook_time"));
-        recipe.difficulty = req.form.get_field("difficulty");
+        recipe.difficulty = difficultyFromString(req.form.get_field("difficulty"));
         recipe.ingredients = req.form.get_field("ingredients");
         recipe.instructions = req.form.get_field("instructions");
 
@@ -272,6 +923,87 @@ int main()
             res.set_content("{\"error\":\"Failed to create recipe\"}", "application/json");
         } });
 
+    // Bulk import: NDJSON (default) or CSV (Content-Type: text/csv), parsed as
+    // it streams in and inserted in batches. A batch is written once it is
+    // full or has waited kBulkFlushInterval, between reads of the body, so no
+    // write transaction is ever open while waiting on the client. Bad lines
+    // are reported and skipped; they don't abort the import.
+    svr.Post("/api/recipes/bulk", [&](const httplib::Request &req, httplib::Response &res,
+                                      const httplib::ContentReader &content_reader)
+             {
+        res.set_header("Access-Control-Allow-Origin", "*");
+
+        const size_t kMaxReportedErrors = 100;
+        ImportFormat format = req.get_header_value("Content-Type").find("text/csv") != std::string::npos
+                                  ? ImportFormat::Csv
+                                  : ImportFormat::Ndjson;
+        int batch = getQueryParamInt(req, "batch", kBulkMaxBatch);
+        if (batch <= 0 || batch > kBulkMaxBatch)
+            batch = kBulkMaxBatch;
+
+        auto start = std::chrono::steady_clock::now();
+        size_t failed = 0;
+        size_t bytes = 0;
+        std::string errors;
+
+        auto reportError = [&](size_t line, const std::string &message) {
+            if (failed++ < kMaxReportedErrors) {
+                if (!errors.empty()) errors += ',';
+                errors += "{\"line\":" + std::to_string(line) + ",\"error\":\"" + jsonEscape(message) + "\"}";
+            }
+        };
+
+        BulkInserter inserter(db.path(), batch, false, reportError);
+        RecipeImportParser parser(
+            format,
+            [&](size_t line, const Recipe &recipe) { inserter.insert(recipe, line); },
+            reportError);
+
+        if (inserter.ok()) {
+            auto lastFlush = std::chrono::steady_clock::now();
+            content_reader([&](const char *data, size_t length) {
+                bytes += length;
+                parser.feed(data, length);
+                auto now = std::chrono::steady_clock::now();
+                if (inserter.queuedCount() > 0 && now - lastFlush >= kBulkFlushInterval) {
+                    inserter.flush();
+                    lastFlush = now;
+                }
+                return inserter.ok() && parser.oversizedLine() == 0;
+            });
+            parser.finish();
+            inserter.finish();
+        }
+        size_t inserted = inserter.insertedCount();
+        // The import went through its own connection. Numbering the new rows
+        // tells the change feed; the sorted lists read their keys back
+        // afterwards, outside the write lock.
+        if (inserted > 0) {
+            ChangeRange numbered;
+            if (db.sequenceNewRows(&numbered) && sortedLists.enabled() && numbered.through > numbered.after)
+                sortedLists.applyImported(db, numbered.after, numbered.through);
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::stringstream report;
+        report << "{\"inserted\":" << inserted
+               << ",\"failed\":" << failed
+               << ",\"bytes\":" << bytes
+               << ",\"elapsed_ms\":" << static_cast<long long>(seconds * 1000)
+               << ",\"rows_per_sec\":" << static_cast<long long>(seconds > 0 ? inserted / seconds : 0)
+               << ",\"errors\":[" << errors << "]";
+        // Batches committed before a failure stay in the database
+        if (!inserter.ok()) {
+            res.status = 500;
+            report << ",\"error\":\"" << jsonEscape(inserter.lastError()) << "\"";
+        } else if (parser.oversizedLine() > 0) {
+            res.status = 413;
+            report << ",\"error\":\"record on line " << parser.oversizedLine() << " exceeds "
+                   << RecipeImportParser::kMaxRecordBytes << " bytes\"";
+        }
+        report << "}";
+        res.set_content(report.str(), "application/json"); });
+
     svr.Put("/api/recipes/:id", [&](const httplib::Request &req, httplib::Response &res)
             {
         res.set_header("Access-Control-Allow-Origin", "*");
@@ -303,7 +1035,7 @@ int main()
         recipe.is_vegetarian = req.form.get_field("is_vegetarian") == "1";
         recipe.is_gluten_free = req.form.get_field("is_gluten_free") == "1";
         recipe.cook_time = std::stoi(req.form.get_field("cook_time"));
-        recipe.difficulty = req.form.get_field("difficulty");
+        recipe.difficulty = difficultyFromString(req.form.get_field("difficulty"));
         recipe.ingredients = req.form.get_field("ingredients");
         recipe.instructions = req.form.get_field("instructions");
 
@@ -327,22 +1059,232 @@ int main()
             res.set_content("{\"error\":\"Failed to delete recipe\"}", "application/json");
         } });
 
+    svr.Get("/api/backup", [&](const httplib::Request &, httplib::Response &res)
+            {
+        BackupStatus status = backups.status();
+        std::stringstream ss;
+        ss << "{\"running\":" << (status.running ? "true" : "false")
+           << ",\"pages_done\":" << status.pagesDone
+           << ",\"pages_total\":" << status.pagesTotal
+           << ",\"successes\":" << status.successes
+           << ",\"failures\":" << status.failures
+           << ",\"last_success_unix\":" << status.lastSuccessUnix
+           << ",\"last_duration_seconds\":" << status.lastDurationSeconds
+           << ",\"last_file\":\"" << jsonEscape(status.lastFile) << "\""
+           << ",\"last_error\":\"" << jsonEscape(status.lastError) << "\"}";
+        res.set_content(ss.str(), "application/json"); });
+
+    svr.Post("/api/backup", [&](const httplib::Request &, httplib::Response &res)
+             {
+        backups.requestBackup();
+        res.status = 202;
+        res.set_content("{\"message\":\"Backup started\"}", "application/json"); });
+
+    svr.Get("/debug/slow-queries", [](const httplib::Request &, httplib::Response &res)
+            { res.set_content(SlowQueryLog::renderJson(), "application/json"); });
+
+    svr.Get("/metrics", [&](const httplib::Request &, httplib::Response &res)
+            {
+        std::string body = Metrics::renderPrometheus();
+
+        BackupStatus backup = backups.status();
+        std::stringstream ss;
+        ss << "# HELP recipe_backup_running Whether a backup is in progress.\n"
+           << "# TYPE recipe_backup_running gauge\n"
+           << "recipe_backup_running " << (backup.running ? 1 : 0) << "\n"
+           << "# HELP recipe_backup_pages Pages copied / total for the current or last backup.\n"
+           << "# TYPE recipe_backup_pages gauge\n"
+           << "recipe_backup_pages{state=\"done\"} " << backup.pagesDone << "\n"
+           << "recipe_backup_pages{state=\"total\"} " << backup.pagesTotal << "\n"
+           << "# HELP recipe_backups_total Finished backups by result.\n"
+           << "# TYPE recipe_backups_total counter\n"
+           << "recipe_backups_total{result=\"success\"} " << backup.successes << "\n"
+           << "recipe_backups_total{result=\"failure\"} " << backup.failures << "\n"
+           << "# HELP recipe_backup_last_success_timestamp_seconds Unix time of the last good backup.\n"
+           << "# TYPE recipe_backup_last_success_timestamp_seconds gauge\n"
+           << "recipe_backup_last_success_timestamp_seconds " << backup.lastSuccessUnix << "\n"
+           << "# HELP recipe_backup_last_duration_seconds Duration of the last good backup.\n"
+           << "# TYPE recipe_backup_last_duration_seconds gauge\n"
+           << "recipe_backup_last_duration_seconds " << backup.lastDurationSeconds << "\n";
+        ss << "# HELP recipe_request_queue_depth Connections waiting for a worker.\n"
+           << "# TYPE recipe_request_queue_depth gauge\n"
+           << "recipe_request_queue_depth " << RequestQueue::depth() << "\n"
+           << "# HELP recipe_parked_connections Idle keep-alive connections waiting in the event loop.\n"
+           << "# TYPE recipe_parked_connections gauge\n"
+           << "recipe_parked_connections " << EventServer::parkedConnections() << "\n"
+           << "# HELP recipe_list_single_flight_total List requests that ran their query (leader) or shared another's (follower).\n"
+           << "# TYPE recipe_list_single_flight_total counter\n"
+           << "recipe_list_single_flight_total{role=\"leader\"} " << listFlights.leaderCount() << "\n"
+           << "recipe_list_single_flight_total{role=\"follower\"} " << listFlights.followerCount() << "\n"
+           << "# HELP recipe_change_feed_streams Open /api/recipes/changes streams.\n"
+           << "# TYPE recipe_change_feed_streams gauge\n"
+           << "recipe_change_feed_streams " << changeFeed.streamCount() << "\n"
+           << "# HELP recipe_change_feed_events_total Change events published since startup.\n"
+           << "# TYPE recipe_change_feed_events_total counter\n"
+           << "recipe_change_feed_events_total " << changeFeed.latest() << "\n"
+           << "# HELP recipe_change_feed_overruns_total Streams that fell a full ring behind and were reset.\n"
+           << "# TYPE recipe_change_feed_overruns_total counter\n"
+           << "recipe_change_feed_overruns_total " << changeFeed.overrunCount() << "\n"
+           << rateLimiter.renderPrometheus();
+        body += ss.str();
+
+        res.set_content(std::move(body), "text/plain; version=0.0.4"); });
+
     svr.Options("/api/recipes", [](const httplib::Request &, httplib::Response &res)
                 {
         res.set_header("Access-Control-Allow-Origin", "*");
         res.set_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
         res.set_header("Access-Control-Allow-Headers", "Content-Type"); });
 
+    svr.Options("/api/recipes/bulk", [](const httplib::Request &, httplib::Response &res)
+                {
+        res.set_header("Access-Control-Allow-Origin", "*");
+        res.set_header("Access-Control-Allow-Methods", "POST, OPTIONS");
+        res.set_header("Access-Control-Allow-Headers", "Content-Type"); });
+
     svr.Options("/api/recipes/:id", [](const httplib::Request &, httplib::Response &res)
                 {
         res.set_header("Access-Control-Allow-Origin", "*");
         res.set_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
         res.set_header("Access-Control-Allow-Headers", "Content-Type"); });
+}
+
+int main(int argc, char **argv)
+{
+    ServerConfig config;
+    if (!loadServerConfig(argc, argv, config))
+    {
+        return 1;
+    }
+
+    // Statements at or above slow_query_ms are kept for /debug/slow-queries.
+    SlowQueryLog::setThresholdMs(config.slowQueryMs);
+
+    Database db(config.dbPath);
+    if (!db.initialize())
+    {
+        std::cerr << "Failed to initialize database" << std::endl;
+        return 1;
+    }
+
+    // Loaded before the server starts, so no write can slip in between.
+    SortedLists sortedLists;
+    if (config.materializedLists)
+    {
+        auto loadStart = std::chrono::steady_clock::now();
+        if (!sortedLists.load(db))
+            return 1;
+        db.addObserver(&sortedLists);
+        std::cout << "Loaded " << sortedLists.size() << " recipes into sorted lists in "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - loadStart).count()
+                  << " ms" << std::endl;
+    }
+
+    // Observers run under the database's write lock, in commit order.
+    ChangeFeed changeFeed(static_cast<uint64_t>(db.latestChangeSeq()));
+    db.addObserver(&changeFeed);
+
+    BackupManager backups(db.path(), config.backup);
+    backups.start();
+
+    // Idle keep-alive connections each hold a descriptor; allow as many as
+    // the hard limit permits.
+    rlimit files;
+    if (getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur < files.rlim_max)
+    {
+        files.rlim_cur = files.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &files);
+    }
+
+    // Totals, split evenly across listeners.
+    int listenerCount = config.listeners > 0 ? config.listeners : 1;
+    int workers = config.workers > 0 ? config.workers : static_cast<int>(CPPHTTPLIB_THREAD_POOL_COUNT);
+    int maxQueued = config.maxQueued > 0 ? config.maxQueued : 1;
+    RequestQueueSettings queueSettings;
+    queueSettings.workers = (workers + listenerCount - 1) / listenerCount;
+    queueSettings.maxQueued = (maxQueued + listenerCount - 1) / listenerCount;
+
+    ExpensiveGate expensiveGate(config.expensiveSlots);
+
+    SingleFlight listFlights;
+    RateLimiter rateLimiter;
+    std::string rateLimitError;
+    if (!rateLimiter.configure(config.rateLimit, config.rateLimitRoutes, rateLimitError))
+    {
+        std::cerr << rateLimitError << std::endl;
+        return 1;
+    }
 
-    std::cout << "Server starting on http://localhost:8080" << std::endl;
-    std::cout << "API endpoints available at http://localhost:8080/api/recipes" << std::endl;
+    std::vector<std::vector<int>> cpuGroups;
+    if (listenerCount > 1 && config.pinCpus)
+        cpuGroups = splitCpus(listenerCount);
 
-    svr.listen("0.0.0.0", 8080);
+    // Each listener binds its own socket to the same port; with SO_REUSEPORT
+    // (set by httplib::default_socket_options) the kernel spreads incoming
+    // connections across them, so there is no single accept loop to contend
+    // on.
+    std::vector<std::unique_ptr<Listener>> listeners;
+    for (int i = 0; i < listenerCount; ++i)
+    {
+        listeners.push_back(std::make_unique<Listener>(config.eventLoop));
+        Listener &listener = *listeners.back();
+        EventServer &svr = listener.server;
+
+        svr.new_task_queue = [queueSettings, &listener]
+        {
+            listener.taskQueue = new ServerTaskQueue(queueSettings);
+            return listener.taskQueue;
+        };
+        // Parked keep-alive connections come back through the same queue.
+        svr.setDispatcher([&listener](std::function<void()> fn)
+                          { return listener.taskQueue && listener.taskQueue->enqueue(std::move(fn)); });
+        svr.set_tcp_nodelay(config.tcpNoDelay);
+        svr.set_keep_alive_max_count(config.keepAliveMaxCount);
+        svr.set_keep_alive_timeout(config.keepAliveTimeoutSeconds);
+        svr.set_read_timeout(config.readTimeoutSeconds);
+        svr.set_write_timeout(config.writeTimeoutSeconds);
+
+        // cpp-httplib listens with a fixed backlog of 5; remember the listening
+        // socket so listen() can be called again with the configured one.
+        svr.set_socket_options([&listener](socket_t sock)
+                               {
+            httplib::default_socket_options(sock);
+            listener.socket = sock; });
+
+        registerRoutes(svr, config, db, backups, expensiveGate, rateLimiter, listFlights, sortedLists,
+                       changeFeed);
+
+        if (!svr.bind_to_port(config.host, config.port))
+        {
+            std::cerr << "Can't listen on " << config.host << ":" << config.port << std::endl;
+            return 1;
+        }
+        if (listener.socket != INVALID_SOCKET && ::listen(listener.socket, config.listenBacklog) != 0)
+        {
+            std::cerr << "Can't set listen backlog to " << config.listenBacklog << std::endl;
+        }
+        if (!cpuGroups.empty())
+            listener.cpus = cpuGroups[i];
+    }
+
+    std::cout << "Server starting on http://localhost:" << config.port << " with " << workers << " workers";
+    if (listenerCount > 1)
+        std::cout << " on " << listenerCount << " listeners" << (cpuGroups.empty() ? "" : " pinned to CPUs");
+    std::cout << std::endl;
+    std::cout << "API endpoints available at http://localhost:" << config.port << "/api/recipes" << std::endl;
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < listeners.size(); ++i)
+    {
+        threads.emplace_back([&listener = *listeners[i]]
+                             {
+            pinCurrentThread(listener.cpus);
+            listener.server.listen_after_bind(); });
+    }
+    pinCurrentThread(listeners[0]->cpus);
+    listeners[0]->server.listen_after_bind();
+    for (std::thread &t : threads)
+        t.join();
 
     return 0;
 }
@@ -0,0 +1,326 @@
+#include "metrics.h"
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Log-linear ("HDR-style") latency buckets over microseconds: values below
+// 8us get exact buckets, then every power of two is split into 8 linear
+// sub-buckets, bounding the relative error at 12.5% up to ~18 minutes.
+const int kSubBucketBits = 3;
+const int kSubBuckets = 1 << kSubBucketBits;
+const int kMaxOctave = 30;
+const int kBucketCount = kSubBuckets + (kMaxOctave - kSubBucketBits + 1) * kSubBuckets;
+
+int bucketFor(uint64_t micros) {
+    if (micros < static_cast<uint64_t>(kSubBuckets)) {
+        return static_cast<int>(micros);
+    }
+    int octave = 63 - __builtin_clzll(micros);
+    if (octave > kMaxOctave) {
+        return kBucketCount - 1;
+    }
+    int sub = static_cast<int>((micros >> (octave - kSubBucketBits)) & (kSubBuckets - 1));
+    return kSubBuckets + (octave - kSubBucketBits) * kSubBuckets + sub;
+}
+
+// Smallest value that lands in the bucket after `bucket`, i.e. this
+// bucket's exclusive upper bound in microseconds.
+uint64_t bucketUpperBound(int bucket) {
+    if (bucket < kSubBuckets) {
+        return bucket + 1;
+    }
+    int octave = (bucket - kSubBuckets) / kSubBuckets + kSubBucketBits;
+    int sub = (bucket - kSubBuckets) % kSubBuckets;
+    return (static_cast<uint64_t>(kSubBuckets + sub + 1)) << (octave - kSubBucketBits);
+}
+
+enum StatusClass { Status2xx, Status3xx, Status4xx, Status5xx, StatusOther, StatusClassCount };
+
+const char* statusClassName(int statusClass) {
+    static const char* names[] = {"2xx", "3xx", "4xx", "5xx", "other"};
+    return names[statusClass];
+}
+
+// Written only by its owning thread; read by scrapes.
+struct Shard {
+    struct RouteStats {
+        std::atomic<uint64_t> requests[StatusClassCount];
+        std::atomic<uint64_t> latencyBuckets[kBucketCount];
+        std::atomic<uint64_t> latencySumMicros;
+        std::atomic<uint64_t> bytesOut;
+        std::atomic<uint64_t> phaseNanos[Metrics::PhaseCount];
+    };
+    RouteStats routes[Metrics::RouteCount];
+    std::atomic<uint64_t> rejections[Metrics::RejectionCount];
+
+    Shard() {
+        for (RouteStats& r : routes) {
+            for (auto& c : r.requests) c.store(0, std::memory_order_relaxed);
+            for (auto& c : r.latencyBuckets) c.store(0, std::memory_order_relaxed);
+            for (auto& c : r.phaseNanos) c.store(0, std::memory_order_relaxed);
+            r.latencySumMicros.store(0, std::memory_order_relaxed);
+            r.bytesOut.store(0, std::memory_order_relaxed);
+        }
+        for (auto& c : rejections) c.store(0, std::memory_order_relaxed);
+    }
+};
+
+// Owner-only increment: a plain load + store, no locked instruction.
+inline void bump(std::atomic<uint64_t>& counter, uint64_t by = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+std::mutex registryMutex;
+std::vector<std::unique_ptr<Shard>>& registry() {
+    static std::vector<std::unique_ptr<Shard>> shards;
+    return shards;
+}
+
+// Shards outlive their threads so counts from exited workers aren't lost.
+Shard& localShard() {
+    thread_local Shard* shard = nullptr;
+    if (!shard) {
+        std::unique_ptr<Shard> created(new Shard());
+        shard = created.get();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        registry().push_back(std::move(created));
+    }
+    return *shard;
+}
+
+// Per-request accumulators for the thread currently serving a request
+struct RequestState {
+    Clock::time_point start;
+    bool active = false;
+    uint64_t streamedBytes = 0;
+    uint64_t phaseNanos[Metrics::PhaseCount] = {};
+    bool phaseOpen[Metrics::PhaseCount] = {};
+};
+thread_local RequestState request;
+
+void appendSeconds(std::ostringstream& out, double seconds) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", seconds);
+    out << buf;
+}
+
+}
+
+const char* Metrics::routeName(Route route) {
+    static const char* names[] = {"list", "get", "create", "update", "delete",
+                                  "bulk", "export", "changes", "sync", "batch", "static", "other"};
+    return names[route];
+}
+
+const char* Metrics::phaseName(Phase phase) {
+    static const char* names[] = {"queue", "db", "decode", "serialize", "write"};
+    return names[phase];
+}
+
+void Metrics::beginRequest() {
+    request.start = Clock::now();
+    request.active = true;
+    request.streamedBytes = 0;
+    for (int p = 0; p < PhaseCount; ++p) {
+        request.phaseNanos[p] = 0;
+    }
+}
+
+void Metrics::endRequest(Route route, int status, uint64_t bytesOut) {
+    if (!request.active) {
+        return;
+    }
+    request.active = false;
+
+    uint64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - request.start).count();
+    int statusClass = status >= 200 && status < 600 ? (status / 100) - 2 : StatusOther;
+
+    Shard::RouteStats& stats = localShard().routes[route];
+    bump(stats.requests[statusClass]);
+    bump(stats.latencyBuckets[bucketFor(micros)]);
+    bump(stats.latencySumMicros, micros);
+    bump(stats.bytesOut, bytesOut + request.streamedBytes);
+    for (int p = 0; p < PhaseCount; ++p) {
+        bump(stats.phaseNanos[p], request.phaseNanos[p]);
+    }
+}
+
+void Metrics::addStreamedBytes(uint64_t bytes) {
+    request.streamedBytes += bytes;
+}
+
+void Metrics::addPhaseTime(Phase phase, Clock::duration elapsed) {
+    request.phaseNanos[phase] += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
+
+void Metrics::addRejection(Rejection reason) {
+    bump(localShard().rejections[reason]);
+}
+
+Metrics::RequestTiming Metrics::currentTiming() {
+    RequestTiming timing;
+    timing.totalMs = request.active ? std::chrono::duration<double, std::milli>(Clock::now() - request.start).count() : 0;
+    for (int p = 0; p < PhaseCount; ++p) {
+        timing.phaseMs[p] = request.phaseNanos[p] / 1e6;
+    }
+    return timing;
+}
+
+std::string Metrics::serverTiming(const RequestTiming& timing) {
+    std::string value;
+    char buf[64];
+    for (int p = 0; p < PhaseCount; ++p) {
+        if (timing.phaseMs[p] <= 0) continue;
+        std::snprintf(buf, sizeof(buf), "%s;dur=%.3f, ", phaseName(static_cast<Phase>(p)), timing.phaseMs[p]);
+        value += buf;
+    }
+    std::snprintf(buf, sizeof(buf), "total;dur=%.3f", timing.totalMs);
+    value += buf;
+    return value;
+}
+
+std::string Metrics::renderPrometheus() {
+    // Sum every shard into plain totals first
+    struct Totals {
+        uint64_t requests[StatusClassCount] = {};
+        uint64_t latencyBuckets[kBucketCount] = {};
+        uint64_t latencySumMicros = 0;
+        uint64_t bytesOut = 0;
+        uint64_t phaseNanos[PhaseCount] = {};
+    };
+    std::vector<Totals> totals(RouteCount);
+    uint64_t rejections[RejectionCount] = {};
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const auto& shard : registry()) {
+            for (int k = 0; k < RejectionCount; ++k) rejections[k] += shard->rejections[k].load(std::memory_order_relaxed);
+            for (int r = 0; r < RouteCount; ++r) {
+                const Shard::RouteStats& s = shard->routes[r];
+                Totals& t = totals[r];
+                for (int c = 0; c < StatusClassCount; ++c) t.requests[c] += s.requests[c].load(std::memory_order_relaxed);
+                for (int b = 0; b < kBucketCount; ++b) t.latencyBuckets[b] += s.latencyBuckets[b].load(std::memory_order_relaxed);
+                for (int p = 0; p < PhaseCount; ++p) t.phaseNanos[p] += s.phaseNanos[p].load(std::memory_order_relaxed);
+                t.latencySumMicros += s.latencySumMicros.load(std::memory_order_relaxed);
+                t.bytesOut += s.bytesOut.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::ostringstream out;
+
+    out << "# HELP recipe_http_requests_total Requests served, by route and status class.\n";
+    out << "# TYPE recipe_http_requests_total counter\n";
+    for (int r = 0; r < RouteCount; ++r) {
+        for (int c = 0; c < StatusClassCount; ++c) {
+            if (totals[r].requests[c] == 0) continue;
+            out << "recipe_http_requests_total{route=\"" << routeName(static_cast<Route>(r))
+                << "\",code=\"" << statusClassName(c) << "\"} " << totals[r].requests[c] << "\n";
+        }
+    }
+
+    // Prometheus buckets at powers of two from 16us to ~33s. They fall on
+    // internal bucket edges, so no interpolation is needed.
+    out << "# HELP recipe_http_request_duration_seconds Time from routing to the last byte written.\n";
+    out << "# TYPE recipe_http_request_duration_seconds histogram\n";
+    for (int r = 0; r < RouteCount; ++r) {
+        const Totals& t = totals[r];
+        const char* name = routeName(static_cast<Route>(r));
+        uint64_t cumulative = 0;
+        int bucket = 0;
+        for (int exp = 4; exp <= 25; ++exp) {
+            uint64_t bound = uint64_t(1) << exp;
+            while (bucket < kBucketCount && bucketUpperBound(bucket) <= bound) {
+                cumulative += t.latencyBuckets[bucket++];
+            }
+            out << "recipe_http_request_duration_seconds_bucket{route=\"" << name << "\",le=\"";
+            appendSeconds(out, bound / 1e6);
+            out << "\"} " << cumulative << "\n";
+        }
+        while (bucket < kBucketCount) {
+            cumulative += t.latencyBuckets[bucket++];
+        }
+        out << "recipe_http_request_duration_seconds_bucket{route=\"" << name << "\",le=\"+Inf\"} " << cumulative << "\n";
+        out << "recipe_http_request_duration_seconds_sum{route=\"" << name << "\"} ";
+        appendSeconds(out, t.latencySumMicros / 1e6);
+        out << "\n";
+        out << "recipe_http_request_duration_seconds_count{route=\"" << name << "\"} " << cumulative << "\n";
+    }
+
+    // Quantiles straight from the fine-grained buckets (upper bound of the
+    // bucket holding the rank), for dashboards without histogram_quantile.
+    out << "# HELP recipe_http_request_duration_quantile_seconds Latency quantiles since start.\n";
+    out << "# TYPE recipe_http_request_duration_quantile_seconds gauge\n";
+    const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+    for (int r = 0; r < RouteCount; ++r) {
+        const Totals& t = totals[r];
+        uint64_t count = 0;
+        for (int b = 0; b < kBucketCount; ++b) count += t.latencyBuckets[b];
+        if (count == 0) continue;
+
+        for (double q : quantiles) {
+            uint64_t rank = static_cast<uint64_t>(q * count);
+            if (rank >= count) rank = count - 1;
+            uint64_t seen = 0;
+            int b = 0;
+            for (; b < kBucketCount; ++b) {
+                seen += t.latencyBuckets[b];
+                if (seen > rank) break;
+            }
+            out << "recipe_http_request_duration_quantile_seconds{route=\"" << routeName(static_cast<Route>(r))
+                << "\",quantile=\"" << q << "\"} ";
+            appendSeconds(out, bucketUpperBound(b) / 1e6);
+            out << "\n";
+        }
+    }
+
+    out << "# HELP recipe_phase_seconds_total Time spent per request phase.\n";
+    out << "# TYPE recipe_phase_seconds_total counter\n";
+    for (int r = 0; r < RouteCount; ++r) {
+        for (int p = 0; p < PhaseCount; ++p) {
+            if (totals[r].phaseNanos[p] == 0) continue;
+            out << "recipe_phase_seconds_total{route=\"" << routeName(static_cast<Route>(r))
+                << "\",phase=\"" << phaseName(static_cast<Phase>(p)) << "\"} ";
+            appendSeconds(out, totals[r].phaseNanos[p] / 1e9);
+            out << "\n";
+        }
+    }
+
+    out << "# HELP recipe_http_response_bytes_total Response body bytes written.\n";
+    out << "# TYPE recipe_http_response_bytes_total counter\n";
+    for (int r = 0; r < RouteCount; ++r) {
+        if (totals[r].bytesOut == 0) continue;
+        out << "recipe_http_response_bytes_total{route=\"" << routeName(static_cast<Route>(r))
+            << "\"} " << totals[r].bytesOut << "\n";
+    }
+
+    static const char* rejectionNames[] = {"queue_full", "busy", "dropped", "queue_wait"};
+    out << "# HELP recipe_http_rejected_total Requests shed under load, by reason.\n";
+    out << "# TYPE recipe_http_rejected_total counter\n";
+    for (int k = 0; k < RejectionCount; ++k) {
+        out << "recipe_http_rejected_total{reason=\"" << rejectionNames[k] << "\"} " << rejections[k] << "\n";
+    }
+
+    return out.str();
+}
+
+PhaseTimer::PhaseTimer(Metrics::Phase phase)
+    : phase(phase), outermost(!request.phaseOpen[phase]) {
+    if (outermost) {
+        request.phaseOpen[phase] = true;
+        start = Clock::now();
+    }
+}
+
+PhaseTimer::~PhaseTimer() {
+    if (outermost) {
+        Metrics::addPhaseTime(phase, Clock::now() - start);
+        request.phaseOpen[phase] = false;
+    }
+}
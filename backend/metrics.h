@@ -0,0 +1,92 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Request metrics exposed at /metrics in Prometheus text format.
+//
+// Each thread that records anything gets its own shard of counters and
+// latency histograms. Only the owning thread writes a shard (relaxed atomic
+// stores, no read-modify-write and no locks), and a scrape sums all shards,
+// so recording costs a few uncontended memory writes per request.
+class Metrics {
+public:
+    enum Route {
+        RouteList,    // GET /api/recipes
+        RouteGet,     // GET /api/recipes/:id
+        RouteCreate,  // POST /api/recipes
+        RouteUpdate,  // PUT /api/recipes/:id
+        RouteDelete,  // DELETE /api/recipes/:id
+        RouteBulk,    // POST /api/recipes/bulk
+        RouteExport,  // GET /api/recipes/export
+        RouteChanges, // GET /api/recipes/changes (long-lived streams)
+        RouteSync,    // GET /api/recipes/sync
+        RouteBatch,   // GET or POST /api/recipes/batch
+        RouteStatic,  // frontend and uploads
+        RouteOther,
+        RouteCount
+    };
+
+    // Time spent inside a request, attributed to the request's route
+    enum Phase {
+        PhaseQueue,     // waiting for a worker or an expensive-request slot
+        PhaseDb,        // preparing and stepping statements
+        PhaseDecode,    // reading column values out of result rows
+        PhaseSerialize, // encoding rows for the response
+        PhaseWrite,     // handing streamed chunks to the socket
+        PhaseCount
+    };
+
+    // Requests turned away under load
+    enum Rejection {
+        RejectQueueFull,  // connection queue full; answered 503 from overflow
+        RejectBusy,       // no expensive-request slot in time; answered 503
+        RejectDropped,    // overflow full too; connection closed unanswered
+        RejectQueueWait,  // waited past max_queue_wait_ms for a worker; answered 503
+        RejectionCount
+    };
+
+    // Breakdown of the request in progress on the calling thread
+    struct RequestTiming {
+        double totalMs;
+        double phaseMs[PhaseCount];
+    };
+
+    static const char* routeName(Route route);
+    static const char* phaseName(Phase phase);
+
+    // Bracket one request on the thread that serves it.
+    static void beginRequest();
+    static void endRequest(Route route, int status, uint64_t bytesOut);
+
+    // Bytes written by streaming responses, whose size isn't known up front.
+    static void addStreamedBytes(uint64_t bytes);
+    static void addPhaseTime(Phase phase, std::chrono::steady_clock::duration elapsed);
+    static void addRejection(Rejection reason);
+
+    static RequestTiming currentTiming();
+    // Server-Timing header value, e.g. "db;dur=1.2, serialize;dur=0.4, total;dur=2.0".
+    // Phases that took no time are left out.
+    static std::string serverTiming(const RequestTiming& timing);
+
+    static std::string renderPrometheus();
+};
+
+// Adds the lifetime of the scope to a phase of the current request. Nested
+// timers for a phase that is already being timed don't count twice.
+class PhaseTimer {
+private:
+    Metrics::Phase phase;
+    bool outermost;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit PhaseTimer(Metrics::Phase phase);
+    ~PhaseTimer();
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+};
+
+#endif
@@ -0,0 +1,165 @@
+#include "rate_limiter.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <functional>
+#include <sstream>
+
+namespace {
+
+// Slot layout: tag (16 bits) | last refill, ms mod 2^28 (28 bits) | tokens
+// in 1/256ths (20 bits). Tag 0 marks an unused slot.
+const int kTokenBits = 20;
+const int kTimeBits = 28;
+const uint64_t kTokenMask = (uint64_t(1) << kTokenBits) - 1;
+const uint64_t kTimeMask = (uint64_t(1) << kTimeBits) - 1;
+const uint64_t kOneToken = 256;
+const double kMaxBurst = double(kTokenMask / kOneToken);
+
+uint64_t tagOf(uint64_t slot) { return slot >> (kTokenBits + kTimeBits); }
+uint64_t timeOf(uint64_t slot) { return (slot >> kTokenBits) & kTimeMask; }
+uint64_t tokensOf(uint64_t slot) { return slot & kTokenMask; }
+
+uint64_t pack(uint64_t tag, uint64_t time, uint64_t tokens) {
+    return (tag << (kTokenBits + kTimeBits)) | ((time & kTimeMask) << kTokenBits) | tokens;
+}
+
+uint64_t mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+bool parseLimit(const std::string& spec, RateLimit& out) {
+    if (spec == "off" || spec == "0") {
+        out = RateLimit();
+        return true;
+    }
+    size_t slash = spec.find('/');
+    if (slash == std::string::npos) {
+        return false;
+    }
+    try {
+        size_t used = 0;
+        out.perSecond = std::stod(spec.substr(0, slash), &used);
+        if (used != slash) {
+            return false;
+        }
+        std::string burst = spec.substr(slash + 1);
+        out.burst = std::stod(burst, &used);
+        if (used != burst.size()) {
+            return false;
+        }
+    } catch (...) {
+        return false;
+    }
+    return out.perSecond > 0 && out.burst >= 1 && out.burst <= kMaxBurst;
+}
+
+}
+
+RateLimiter::RateLimiter() : epoch(Clock::now()) {
+    for (int r = 0; r < Metrics::RouteCount; ++r) {
+        limited[r].store(0, std::memory_order_relaxed);
+    }
+}
+
+bool RateLimiter::configure(const std::string& defaults, const std::string& routes, std::string& error) {
+    RateLimit fallback;
+    if (!parseLimit(defaults, fallback)) {
+        error = "rate_limit: expected rate/burst (burst 1.." + std::to_string(int(kMaxBurst)) +
+                ") or off, got '" + defaults + "'";
+        return false;
+    }
+    for (int r = 0; r < Metrics::RouteCount; ++r) {
+        limits[r] = fallback;
+    }
+
+    std::stringstream list(routes);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        item.erase(std::remove_if(item.begin(), item.end(), [](unsigned char c) { return std::isspace(c); }),
+                   item.end());
+        if (item.empty()) {
+            continue;
+        }
+        size_t colon = item.find(':');
+        std::string name = item.substr(0, colon);
+        int route = 0;
+        while (route < Metrics::RouteCount && name != Metrics::routeName(static_cast<Metrics::Route>(route))) {
+            ++route;
+        }
+        if (colon == std::string::npos || route == Metrics::RouteCount ||
+            !parseLimit(item.substr(colon + 1), limits[route])) {
+            error = "rate_limit_routes: expected route:rate/burst, got '" + item + "'";
+            return false;
+        }
+    }
+
+    bool any = false;
+    for (int r = 0; r < Metrics::RouteCount; ++r) {
+        any = any || limits[r].perSecond > 0;
+    }
+    if (!any) {
+        slots.reset();
+        return true;
+    }
+    slots.reset(new std::atomic<uint64_t>[kSlots]);
+    for (size_t i = 0; i < kSlots; ++i) {
+        slots[i].store(0, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+bool RateLimiter::admit(const std::string& clientIp, Metrics::Route route, int& retryAfterSeconds) {
+    const RateLimit& limit = limits[route];
+    if (!slots || limit.perSecond <= 0) {
+        return true;
+    }
+
+    uint64_t hash = mix(std::hash<std::string>()(clientIp) ^ (uint64_t(route) << 56));
+    std::atomic<uint64_t>& slot = slots[hash & (kSlots - 1)];
+    uint64_t tag = (hash >> 48) | 1;
+    uint64_t burst = static_cast<uint64_t>(limit.burst * kOneToken);
+    uint64_t now = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - epoch).count());
+
+    uint64_t current = slot.load(std::memory_order_relaxed);
+    for (;;) {
+        uint64_t tokens = burst;
+        uint64_t refilledAt = now;
+        if (tagOf(current) == tag) {
+            uint64_t elapsed = (now - timeOf(current)) & kTimeMask;
+            uint64_t added = static_cast<uint64_t>(elapsed * limit.perSecond * kOneToken / 1000);
+            tokens = std::min(burst, tokensOf(current) + added);
+            // Keep the old timestamp until a whole 1/256 token has accrued,
+            // so clients polling faster than that still refill.
+            if (added == 0) {
+                refilledAt = timeOf(current);
+            }
+        }
+
+        bool allowed = tokens >= kOneToken;
+        uint64_t next = pack(tag, refilledAt, allowed ? tokens - kOneToken : tokens);
+        if (next == current || slot.compare_exchange_weak(current, next, std::memory_order_relaxed)) {
+            if (!allowed) {
+                double missing = double(kOneToken - tokens) / kOneToken;
+                retryAfterSeconds = std::max(1, static_cast<int>(std::ceil(missing / limit.perSecond)));
+                limited[route].fetch_add(1, std::memory_order_relaxed);
+            }
+            return allowed;
+        }
+    }
+}
+
+std::string RateLimiter::renderPrometheus() const {
+    std::ostringstream out;
+    out << "# HELP recipe_http_rate_limited_total Requests answered 429, by route.\n";
+    out << "# TYPE recipe_http_rate_limited_total counter\n";
+    for (int r = 0; r < Metrics::RouteCount; ++r) {
+        out << "recipe_http_rate_limited_total{route=\"" << Metrics::routeName(static_cast<Metrics::Route>(r))
+            << "\"} " << limited[r].load(std::memory_order_relaxed) << "\n";
+    }
+    return out.str();
+}
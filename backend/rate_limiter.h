@@ -0,0 +1,52 @@
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include "metrics.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Sustained requests per second and how many may arrive at once.
+struct RateLimit {
+    double perSecond = 0;  // <= 0: unlimited
+    double burst = 0;
+};
+
+// Token buckets per client IP and route, checked before routing.
+//
+// Buckets live in a fixed table of 64k slots, each a single 64-bit word
+// (key tag, last refill time, tokens) updated with compare-and-swap, so
+// admitting a request takes no lock and clients only contend when they hash
+// to the same slot. A client whose slot is taken over by another starts
+// again with a full bucket; with 64k slots that errs, rarely, on the side of
+// letting requests through.
+class RateLimiter {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    RateLimit limits[Metrics::RouteCount];
+    std::unique_ptr<std::atomic<uint64_t>[]> slots;
+    std::atomic<uint64_t> limited[Metrics::RouteCount];
+    Clock::time_point epoch;
+
+public:
+    static const size_t kSlots = 1 << 16;
+
+    RateLimiter();
+
+    // defaults is "rate/burst" (or "off") for every route; routes overrides
+    // it per route, e.g. "list:5/20,export:1/2". On a malformed spec,
+    // returns false and describes the problem in error.
+    bool configure(const std::string& defaults, const std::string& routes, std::string& error);
+    bool enabled() const { return slots != nullptr; }
+
+    // Takes a token from the client's bucket for this route. When none is
+    // left returns false and sets retryAfterSeconds.
+    bool admit(const std::string& clientIp, Metrics::Route route, int& retryAfterSeconds);
+
+    std::string renderPrometheus() const;
+};
+
+#endif
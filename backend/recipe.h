@@ -1,7 +1,38 @@
 #ifndef RECIPE_H
 #define RECIPE_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
+
+// Stored as the integer rank in recipes.difficulty (see the difficulties
+// table), so ORDER BY difficulty sorts easy < medium < hard.
+enum class Difficulty : std::uint8_t {
+    Easy = 1,
+    Medium = 2,
+    Hard = 3
+};
+
+inline const char* difficultyToString(Difficulty difficulty) {
+    switch (difficulty) {
+    case Difficulty::Easy: return "easy";
+    case Difficulty::Hard: return "hard";
+    default: return "medium";
+    }
+}
+
+// Unknown names fall back to medium, matching the column default.
+inline Difficulty difficultyFromString(const std::string& name) {
+    if (name == "easy") return Difficulty::Easy;
+    if (name == "hard") return Difficulty::Hard;
+    return Difficulty::Medium;
+}
+
+inline Difficulty difficultyFromRank(int rank) {
+    if (rank == static_cast<int>(Difficulty::Easy)) return Difficulty::Easy;
+    if (rank == static_cast<int>(Difficulty::Hard)) return Difficulty::Hard;
+    return Difficulty::Medium;
+}
 
 struct Recipe {
     int id;
@@ -14,10 +45,83 @@ struct Recipe {
     bool is_vegetarian;
     bool is_gluten_free;
     int cook_time;
-    std::string difficulty;
+    Difficulty difficulty;
     std::string ingredients;
     std::string instructions;
     std::string created_at;
+    int version;  // 1 when inserted, bumped by every update
+    long long change_seq;  // position in the database's change sequence
 };
 
+// What is left of a deleted recipe, for delta sync.
+struct RecipeTombstone {
+    int id;
+    int version;  // the deleted row's version plus one
+    long long change_seq;
+};
+
+// Non-owning form of Recipe. The text fields point at memory owned by
+// someone else (a Recipe, or SQLite's column buffers for RecipeCursor rows)
+// and are only valid as long as that owner.
+struct RecipeView {
+    int id;
+    std::string_view title;
+    std::string_view description;
+    std::string_view image_url;
+    double protein;
+    double carbs;
+    bool is_vegan;
+    bool is_vegetarian;
+    bool is_gluten_free;
+    Difficulty difficulty;
+    int cook_time;
+    std::string_view ingredients;
+    std::string_view instructions;
+    std::string_view created_at;
+    int version;
+    long long change_seq;
+};
+
+inline RecipeView viewOf(const Recipe& recipe) {
+    RecipeView view;
+    view.id = recipe.id;
+    view.title = recipe.title;
+    view.description = recipe.description;
+    view.image_url = recipe.image_url;
+    view.protein = recipe.protein;
+    view.carbs = recipe.carbs;
+    view.is_vegan = recipe.is_vegan;
+    view.is_vegetarian = recipe.is_vegetarian;
+    view.is_gluten_free = recipe.is_gluten_free;
+    view.difficulty = recipe.difficulty;
+    view.cook_time = recipe.cook_time;
+    view.ingredients = recipe.ingredients;
+    view.instructions = recipe.instructions;
+    view.created_at = recipe.created_at;
+    view.version = recipe.version;
+    view.change_seq = recipe.change_seq;
+    return view;
+}
+
+inline Recipe recipeFromView(const RecipeView& view) {
+    Recipe recipe;
+    recipe.id = view.id;
+    recipe.title = std::string(view.title);
+    recipe.description = std::string(view.description);
+    recipe.image_url = std::string(view.image_url);
+    recipe.protein = view.protein;
+    recipe.carbs = view.carbs;
+    recipe.is_vegan = view.is_vegan;
+    recipe.is_vegetarian = view.is_vegetarian;
+    recipe.is_gluten_free = view.is_gluten_free;
+    recipe.cook_time = view.cook_time;
+    recipe.difficulty = view.difficulty;
+    recipe.ingredients = std::string(view.ingredients);
+    recipe.instructions = std::string(view.instructions);
+    recipe.created_at = std::string(view.created_at);
+    recipe.version = view.version;
+    recipe.change_seq = view.change_seq;
+    return recipe;
+}
+
 #endif
@@ -0,0 +1,144 @@
+#include "recipe_cursor.h"
+#include "metrics.h"
+#include <cstring>
+#include <iostream>
+#include <string_view>
+#include <utility>
+
+namespace {
+
+std::string_view columnText(sqlite3_stmt* stmt, int col) {
+    if (col < 0) {
+        return std::string_view();
+    }
+    const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, col));
+    if (!text) {
+        return std::string_view();
+    }
+    return std::string_view(text, sqlite3_column_bytes(stmt, col));
+}
+
+int columnInt(sqlite3_stmt* stmt, int col) {
+    return col < 0 ? 0 : sqlite3_column_int(stmt, col);
+}
+
+long long columnInt64(sqlite3_stmt* stmt, int col) {
+    return col < 0 ? 0 : sqlite3_column_int64(stmt, col);
+}
+
+double columnDouble(sqlite3_stmt* stmt, int col) {
+    return col < 0 ? 0.0 : sqlite3_column_double(stmt, col);
+}
+
+}
+
+RecipeColumns RecipeColumns::resolve(sqlite3_stmt* stmt) {
+    RecipeColumns cols;
+    std::memset(&cols, -1, sizeof(cols));
+
+    struct Field {
+        const char* name;
+        int RecipeColumns::*slot;
+    };
+    static const Field fields[] = {
+        {"id", &RecipeColumns::id},
+        {"title", &RecipeColumns::title},
+        {"description", &RecipeColumns::description},
+        {"image_url", &RecipeColumns::image_url},
+        {"protein", &RecipeColumns::protein},
+        {"carbs", &RecipeColumns::carbs},
+        {"is_vegan", &RecipeColumns::is_vegan},
+        {"is_vegetarian", &RecipeColumns::is_vegetarian},
+        {"is_gluten_free", &RecipeColumns::is_gluten_free},
+        {"cook_time", &RecipeColumns::cook_time},
+        {"difficulty", &RecipeColumns::difficulty},
+        {"ingredients", &RecipeColumns::ingredients},
+        {"instructions", &RecipeColumns::instructions},
+        {"created_at", &RecipeColumns::created_at},
+        {"version", &RecipeColumns::version},
+        {"change_seq", &RecipeColumns::change_seq},
+    };
+
+    int count = sqlite3_column_count(stmt);
+    for (int i = 0; i < count; ++i) {
+        const char* name = sqlite3_column_name(stmt, i);
+        for (const Field& field : fields) {
+            if (std::strcmp(name, field.name) == 0) {
+                cols.*field.slot = i;
+                break;
+            }
+        }
+    }
+    return cols;
+}
+
+RecipeCursor::RecipeCursor(sqlite3_stmt* statement, std::shared_ptr<sqlite3> connection)
+    : stmt(statement), connection(std::move(connection)), columns(), current(), failed(false) {
+    if (stmt) {
+        columns = RecipeColumns::resolve(stmt);
+    }
+}
+
+RecipeCursor::~RecipeCursor() {
+    if (stmt) {
+        sqlite3_finalize(stmt);
+    }
+}
+
+RecipeCursor::RecipeCursor(RecipeCursor&& other) noexcept
+    : stmt(other.stmt), connection(std::move(other.connection)), columns(other.columns),
+      current(other.current), failed(other.failed) {
+    other.stmt = nullptr;
+}
+
+RecipeCursor& RecipeCursor::operator=(RecipeCursor&& other) noexcept {
+    if (this != &other) {
+        std::swap(stmt, other.stmt);
+        std::swap(connection, other.connection);
+        std::swap(columns, other.columns);
+        std::swap(current, other.current);
+        std::swap(failed, other.failed);
+    }
+    return *this;
+}
+
+bool RecipeCursor::next() {
+    if (!stmt || failed) {
+        return false;
+    }
+
+    int rc;
+    {
+        PhaseTimer timer(Metrics::PhaseDb);
+        rc = sqlite3_step(stmt);
+    }
+    if (rc == SQLITE_ROW) {
+        PhaseTimer timer(Metrics::PhaseDecode);
+        decode();
+        return true;
+    }
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Failed to step statement: " << sqlite3_errmsg(sqlite3_db_handle(stmt)) << std::endl;
+        failed = true;
+    }
+    return false;
+}
+
+void RecipeCursor::decode() {
+    current.id = columnInt(stmt, columns.id);
+    current.title = columnText(stmt, columns.title);
+    current.description = columnText(stmt, columns.description);
+    current.image_url = columnText(stmt, columns.image_url);
+    current.protein = columnDouble(stmt, columns.protein);
+    current.carbs = columnDouble(stmt, columns.carbs);
+    current.is_vegan = columnInt(stmt, columns.is_vegan);
+    current.is_vegetarian = columnInt(stmt, columns.is_vegetarian);
+    current.is_gluten_free = columnInt(stmt, columns.is_gluten_free);
+    current.cook_time = columnInt(stmt, columns.cook_time);
+    current.difficulty = difficultyFromRank(columnInt(stmt, columns.difficulty));
+    current.ingredients = columnText(stmt, columns.ingredients);
+    current.instructions = columnText(stmt, columns.instructions);
+    current.created_at = columnText(stmt, columns.created_at);
+    current.version = columnInt(stmt, columns.version);
+    current.change_seq = columnInt64(stmt, columns.change_seq);
+}
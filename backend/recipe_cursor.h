@@ -0,0 +1,75 @@
+#ifndef RECIPE_CURSOR_H
+#define RECIPE_CURSOR_H
+
+#include "recipe.h"
+#include <cstddef>
+#include <memory>
+#include <sqlite3.h>
+
+// Where each recipe field lives in a prepared statement's result columns.
+// Resolved once by column name after prepare, so queries are not tied to
+// the SELECT * column order; fields the query doesn't return are -1.
+struct RecipeColumns {
+    int id;
+    int title;
+    int description;
+    int image_url;
+    int protein;
+    int carbs;
+    int is_vegan;
+    int is_vegetarian;
+    int is_gluten_free;
+    int cook_time;
+    int difficulty;
+    int ingredients;
+    int instructions;
+    int created_at;
+    int version;
+    int change_seq;
+
+    static RecipeColumns resolve(sqlite3_stmt* stmt);
+};
+
+// Owns a prepared recipe query and decodes one row per next(). row() views
+// point straight into SQLite's column buffers -- no copy is made -- so they
+// are only valid until the following next() or the cursor's destruction.
+// NULL columns decode as empty text / zero.
+class RecipeCursor {
+private:
+    sqlite3_stmt* stmt;
+    std::shared_ptr<sqlite3> connection;  // released after stmt is finalized
+    RecipeColumns columns;
+    RecipeView current;
+    bool failed;
+
+    void decode();
+
+public:
+    // Takes ownership of an already-bound statement; nullptr makes an empty
+    // cursor (used when prepare fails). connection, if given, is held until
+    // the statement is finalized (a pooled reader).
+    explicit RecipeCursor(sqlite3_stmt* statement = nullptr, std::shared_ptr<sqlite3> connection = nullptr);
+    ~RecipeCursor();
+    RecipeCursor(RecipeCursor&& other) noexcept;
+    RecipeCursor& operator=(RecipeCursor&& other) noexcept;
+    RecipeCursor(const RecipeCursor&) = delete;
+    RecipeCursor& operator=(const RecipeCursor&) = delete;
+
+    bool next();
+    const RecipeView& row() const { return current; }
+    // False if preparing or stepping the statement failed.
+    bool ok() const { return stmt != nullptr && !failed; }
+
+    // Calls fn(const RecipeView&) for each remaining row; returns the count.
+    template <typename RowFn>
+    size_t forEach(RowFn&& fn) {
+        size_t count = 0;
+        while (next()) {
+            fn(current);
+            ++count;
+        }
+        return count;
+    }
+};
+
+#endif
@@ -0,0 +1,370 @@
+// Synthetic recipe corpus generator for scale testing.
+//
+//   ./recipe_gen [--db=recipes.db] [--count=1000000] [--seed=42] [--batch=50000] [--replace]
+//
+// Recipes are assembled from ingredients, so the fields agree with each
+// other: dietary flags follow from what is in the recipe (vegan implies
+// vegetarian, wheat rules out gluten-free), protein and carbs are summed
+// from the ingredients, and long, many-step recipes tend to be harder.
+// Text lengths are log-normal like real user content: most descriptions are
+// a sentence or two, a few run to paragraphs.
+//
+// The same seed always produces the same rows on any platform: the random
+// source and distributions are implemented here rather than taken from
+// <random>, whose distributions differ between standard libraries.
+
+#include "database.h"
+#include <sqlite3.h>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// splitmix64 (Steele et al.): tiny, fast, and identical everywhere
+class Rng
+{
+private:
+    uint64_t state;
+
+public:
+    explicit Rng(uint64_t seed) : state(seed) {}
+
+    uint64_t next()
+    {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    // [0, 1)
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+    // [0, n)
+    size_t below(size_t n) { return static_cast<size_t>(uniform() * n); }
+    bool chance(double p) { return uniform() < p; }
+
+    double normal()
+    {
+        // Box-Muller
+        double u1 = 1.0 - uniform();
+        double u2 = uniform();
+        return std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+    }
+
+    // Log-normal with the given median; sigma is the spread in log space
+    double logNormal(double median, double sigma) { return median * std::exp(sigma * normal()); }
+
+    int logNormalInt(double median, double sigma, int lo, int hi)
+    {
+        int v = static_cast<int>(std::lround(logNormal(median, sigma)));
+        return v < lo ? lo : (v > hi ? hi : v);
+    }
+};
+
+enum Category
+{
+    Meat,
+    Fish,
+    Dairy,
+    Egg,
+    Grain,    // contains gluten
+    GlutenFreeGrain,
+    Legume,
+    Vegetable,
+    Fruit,
+    Nut,
+    Seasoning
+};
+
+struct Ingredient
+{
+    const char *name;
+    Category category;
+    double protein; // grams per typical portion in a recipe
+    double carbs;
+};
+
+const Ingredient kIngredients[] = {
+    {"chicken thighs", Meat, 26, 0}, {"chicken breast", Meat, 31, 0}, {"ground beef", Meat, 24, 0},
+    {"pork shoulder", Meat, 22, 0}, {"lamb shank", Meat, 25, 0}, {"bacon", Meat, 12, 1},
+    {"chorizo", Meat, 14, 2}, {"turkey mince", Meat, 27, 0}, {"salmon fillet", Fish, 25, 0},
+    {"cod", Fish, 20, 0}, {"prawns", Fish, 18, 1}, {"tuna", Fish, 26, 0}, {"anchovies", Fish, 6, 0},
+    {"butter", Dairy, 0, 0}, {"whole milk", Dairy, 8, 12}, {"greek yogurt", Dairy, 10, 4},
+    {"parmesan", Dairy, 10, 1}, {"feta", Dairy, 6, 1}, {"mozzarella", Dairy, 7, 1},
+    {"crème fraîche", Dairy, 1, 2}, {"gruyère", Dairy, 8, 0}, {"double cream", Dairy, 1, 2},
+    {"eggs", Egg, 12, 1}, {"egg yolks", Egg, 5, 0}, {"plain flour", Grain, 4, 38},
+    {"spaghetti", Grain, 7, 42}, {"sourdough bread", Grain, 6, 30}, {"couscous", Grain, 6, 36},
+    {"pearl barley", Grain, 5, 40}, {"panko breadcrumbs", Grain, 3, 20}, {"soy sauce", Grain, 1, 1},
+    {"basmati rice", GlutenFreeGrain, 4, 45}, {"quinoa", GlutenFreeGrain, 8, 39},
+    {"polenta", GlutenFreeGrain, 3, 30}, {"rice noodles", GlutenFreeGrain, 3, 44},
+    {"oats", GlutenFreeGrain, 5, 27}, {"potatoes", Vegetable, 4, 35}, {"sweet potato", Vegetable, 2, 27},
+    {"chickpeas", Legume, 9, 27}, {"red lentils", Legume, 12, 30}, {"black beans", Legume, 8, 23},
+    {"firm tofu", Legume, 15, 3}, {"tempeh", Legume, 19, 9}, {"edamame", Legume, 11, 9},
+    {"onion", Vegetable, 1, 9}, {"garlic", Vegetable, 0, 2}, {"carrots", Vegetable, 1, 10},
+    {"spinach", Vegetable, 3, 4}, {"kale", Vegetable, 3, 6}, {"tomatoes", Vegetable, 1, 5},
+    {"bell pepper", Vegetable, 1, 6}, {"courgette", Vegetable, 1, 3}, {"aubergine", Vegetable, 1, 6},
+    {"mushrooms", Vegetable, 3, 3}, {"broccoli", Vegetable, 3, 7}, {"jalapeño", Vegetable, 0, 1},
+    {"pak choi", Vegetable, 1, 2}, {"lemon", Fruit, 0, 3}, {"lime", Fruit, 0, 2},
+    {"apples", Fruit, 0, 25}, {"bananas", Fruit, 1, 27}, {"blueberries", Fruit, 1, 14},
+    {"mango", Fruit, 1, 25}, {"almonds", Nut, 6, 6}, {"cashews", Nut, 5, 9}, {"peanut butter", Nut, 8, 6},
+    {"tahini", Nut, 5, 3}, {"walnuts", Nut, 4, 4}, {"olive oil", Seasoning, 0, 0},
+    {"sea salt", Seasoning, 0, 0}, {"black pepper", Seasoning, 0, 0}, {"smoked paprika", Seasoning, 0, 1},
+    {"cumin", Seasoning, 0, 1}, {"fresh basil", Seasoning, 0, 0}, {"coriander", Seasoning, 0, 0},
+    {"ginger", Seasoning, 0, 1}, {"chilli flakes", Seasoning, 0, 0}, {"maple syrup", Seasoning, 0, 13},
+    {"honey", Seasoning, 0, 17}, {"vegetable stock", Seasoning, 1, 3}, {"za'atar", Seasoning, 0, 1},
+};
+const size_t kIngredientCount = sizeof(kIngredients) / sizeof(kIngredients[0]);
+
+const char *kAdjectives[] = {"Easy", "Quick", "Smoky", "Crispy", "Creamy", "Spicy", "Rustic", "Weeknight",
+                             "Herby", "Golden", "Zesty", "Slow-cooked", "One-pan", "Grandma's", "Charred"};
+const char *kDishes[] = {"Stew", "Curry", "Traybake", "Salad", "Bowl", "Soup", "Pie", "Stir-fry", "Bake",
+                         "Pasta", "Tacos", "Risotto", "Frittata", "Gratin", "Skewers", "Porridge"};
+const char *kMethods[] = {"Chop", "Dice", "Slice", "Whisk", "Simmer", "Roast", "Fry", "Stir", "Fold",
+                          "Season", "Bake", "Grill", "Blend", "Toast", "Drizzle", "Rest"};
+const char *kFiller[] = {"the", "until", "golden", "and", "softened", "over", "a", "medium", "heat",
+                         "for", "minutes", "with", "gently", "then", "add", "tender", "fragrant",
+                         "covered", "occasionally", "stirring", "well", "to", "taste", "before", "serving"};
+const char *kDescribe[] = {"A", "comforting", "bright", "family", "favourite", "that", "comes", "together",
+                           "in", "no", "time", "perfect", "for", "busy", "weeknights", "packed", "with",
+                           "flavour", "and", "colour", "leftovers", "keep", "well", "naturally", "satisfying",
+                           "crowd-pleasing", "dinner", "party", "showstopper", "lunchbox", "friendly"};
+
+template <size_t N>
+const char *pick(Rng &rng, const char *(&words)[N])
+{
+    return words[rng.below(N)];
+}
+
+std::string words(Rng &rng, const char **vocabulary, size_t size, int count)
+{
+    std::string s;
+    for (int i = 0; i < count; ++i)
+    {
+        if (i > 0)
+            s += ' ';
+        s += vocabulary[rng.below(size)];
+    }
+    return s;
+}
+
+enum Diet
+{
+    DietVegan,
+    DietVegetarian,
+    DietAny
+};
+
+bool allowed(Diet diet, Category category)
+{
+    if (diet == DietAny)
+        return true;
+    if (category == Meat || category == Fish)
+        return false;
+    return diet == DietVegetarian || (category != Dairy && category != Egg);
+}
+
+class Generator
+{
+private:
+    Rng rng;
+    int64_t firstCreated; // unix seconds of the oldest recipe
+    int64_t spanSeconds;
+    size_t total;
+
+    std::string createdAt(size_t index)
+    {
+        // Spread evenly over the span in insertion order, with jitter that
+        // never reorders rows by more than a few neighbours.
+        double step = static_cast<double>(spanSeconds) / (total > 1 ? total : 1);
+        int64_t t = firstCreated + static_cast<int64_t>(step * (index + rng.uniform()));
+        time_t seconds = static_cast<time_t>(t);
+        struct tm parts;
+        gmtime_r(&seconds, &parts);
+        char buf[32];
+        std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &parts);
+        return buf;
+    }
+
+public:
+    Generator(uint64_t seed, size_t total)
+        : rng(seed), firstCreated(1672531200 /* 2023-01-01 */), spanSeconds(3LL * 365 * 24 * 3600),
+          total(total) {}
+
+    Recipe make(size_t index)
+    {
+        Recipe recipe;
+
+        double roll = rng.uniform();
+        Diet diet = roll < 0.12 ? DietVegan : (roll < 0.30 ? DietVegetarian : DietAny);
+        // Some recipes aim for gluten-free and pick only naturally GF grains
+        bool avoidGluten = rng.chance(0.15);
+
+        int ingredientCount = rng.logNormalInt(9, 0.35, 3, 30);
+        std::vector<const Ingredient *> chosen;
+        bool hasMeat = false, hasAnimal = false, hasGluten = false;
+        const Ingredient *star = nullptr;
+        for (int attempts = 0; static_cast<int>(chosen.size()) < ingredientCount && attempts < 200; ++attempts)
+        {
+            const Ingredient &candidate = kIngredients[rng.below(kIngredientCount)];
+            if (!allowed(diet, candidate.category) || (avoidGluten && candidate.category == Grain))
+                continue;
+            bool duplicate = false;
+            for (const Ingredient *c : chosen)
+                duplicate = duplicate || c == &candidate;
+            if (duplicate)
+                continue;
+
+            chosen.push_back(&candidate);
+            hasMeat = hasMeat || candidate.category == Meat || candidate.category == Fish;
+            hasAnimal = hasAnimal || hasMeat || candidate.category == Dairy || candidate.category == Egg;
+            hasGluten = hasGluten || candidate.category == Grain;
+            if (!star && candidate.category != Seasoning)
+                star = &candidate;
+        }
+
+        double protein = 0, carbs = 0;
+        for (const Ingredient *ingredient : chosen)
+        {
+            // Portion sizes vary; keep one decimal like hand-entered values
+            double scale = rng.logNormal(1.0, 0.3);
+            protein += ingredient->protein * scale;
+            carbs += ingredient->carbs * scale;
+        }
+        int servings = 2 + static_cast<int>(rng.below(5));
+        recipe.protein = std::round(protein / servings * 10) / 10;
+        recipe.carbs = std::round(carbs / servings * 10) / 10;
+
+        recipe.is_vegan = !hasAnimal;
+        recipe.is_vegetarian = !hasMeat;
+        recipe.is_gluten_free = !hasGluten;
+
+        std::string starName = star ? star->name : "Vegetable";
+        starName[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(starName[0])));
+        recipe.title = std::string(pick(rng, kAdjectives)) + " " + starName + " " + pick(rng, kDishes);
+
+        recipe.description = words(rng, kDescribe, sizeof(kDescribe) / sizeof(kDescribe[0]),
+                                   rng.logNormalInt(22, 0.6, 4, 400)) +
+                             ".";
+
+        for (size_t i = 0; i < chosen.size(); ++i)
+        {
+            if (i > 0)
+                recipe.ingredients += ", ";
+            recipe.ingredients += chosen[i]->name;
+        }
+
+        int steps = rng.logNormalInt(7, 0.45, 2, 40);
+        for (int step = 1; step <= steps; ++step)
+        {
+            if (step > 1)
+                recipe.instructions += "\n";
+            recipe.instructions += std::to_string(step) + ". " + pick(rng, kMethods) + " " +
+                                   words(rng, kFiller, sizeof(kFiller) / sizeof(kFiller[0]),
+                                         rng.logNormalInt(12, 0.5, 3, 80)) +
+                                   ".";
+        }
+
+        recipe.cook_time = rng.logNormalInt(35 + 2.0 * steps, 0.55, 5, 720);
+
+        // Longer, more involved recipes skew harder
+        double effort = std::log(recipe.cook_time) / 6.0 + steps / 25.0 + 0.25 * rng.normal();
+        recipe.difficulty = effort < 0.75 ? Difficulty::Easy : (effort < 1.1 ? Difficulty::Medium : Difficulty::Hard);
+
+        if (rng.chance(0.7))
+            recipe.image_url = "/uploads/generated_" + std::to_string(index % 5000) + ".jpg";
+
+        recipe.created_at = createdAt(index);
+        return recipe;
+    }
+};
+
+bool parseArg(const std::string &arg, const char *name, std::string &value)
+{
+    std::string prefix = std::string("--") + name + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0)
+        return false;
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    std::string dbPath = "recipes.db";
+    size_t count = 1000000;
+    uint64_t seed = 42;
+    size_t batch = 50000;
+    bool replace = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i], value;
+        if (parseArg(arg, "db", value))
+            dbPath = value;
+        else if (parseArg(arg, "count", value))
+            count = std::strtoull(value.c_str(), nullptr, 10);
+        else if (parseArg(arg, "seed", value))
+            seed = std::strtoull(value.c_str(), nullptr, 10);
+        else if (parseArg(arg, "batch", value))
+            batch = std::strtoull(value.c_str(), nullptr, 10);
+        else if (arg == "--replace")
+            replace = true;
+        else
+        {
+            std::cerr << "usage: " << argv[0]
+                      << " [--db=recipes.db] [--count=1000000] [--seed=42] [--batch=50000] [--replace]" << std::endl;
+            return 2;
+        }
+    }
+
+    // Creates or migrates the schema. --replace goes through the tombstone
+    // path, so sync clients see the old rows deleted; run it with the
+    // server stopped, since the server only learns of these writes (and of
+    // the generated rows) when it next starts.
+    {
+        Database db(dbPath);
+        if (!db.initialize())
+        {
+            std::cerr << "Failed to initialize database" << std::endl;
+            return 1;
+        }
+        if (replace && !db.deleteAllRecipes())
+        {
+            std::cerr << "Failed to clear recipes" << std::endl;
+            return 1;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Generator generator(seed, count);
+    BulkInserter inserter(dbPath, batch, true);
+    for (size_t i = 0; i < count && inserter.ok(); ++i)
+    {
+        inserter.insert(generator.make(i));
+        if ((i + 1) % 100000 == 0)
+            std::cout << "  " << (i + 1) << " / " << count << std::endl;
+    }
+    if (!inserter.finish() || !inserter.ok())
+    {
+        std::cerr << "Generation failed: " << inserter.lastError() << std::endl;
+        return 1;
+    }
+
+    size_t inserted = inserter.insertedCount();
+    // Opening the database numbers the new rows (after the tombstones)
+    if (!Database(dbPath).initialize())
+        return 1;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%zu recipes written to %s in %.1fs (%.0f rows/s)\n", inserted, dbPath.c_str(), seconds,
+                seconds > 0 ? inserted / seconds : 0.0);
+    return 0;
+}
@@ -0,0 +1,463 @@
+#include "recipe_import.h"
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+
+namespace {
+
+void appendUtf8(std::string& out, unsigned long cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xc0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xe0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    } else {
+        out += static_cast<char>(0xf0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    }
+}
+
+class JsonScanner {
+private:
+    std::string_view s;
+    size_t pos;
+
+public:
+    explicit JsonScanner(std::string_view text) : s(text), pos(0) {}
+
+    void skipSpace() {
+        while (pos < s.size() && (s[pos] == ' ' || s[pos] == '\t' || s[pos] == '\r' || s[pos] == '\n')) {
+            ++pos;
+        }
+    }
+
+    bool atEnd() { skipSpace(); return pos >= s.size(); }
+
+    bool consume(char c) {
+        skipSpace();
+        if (pos < s.size() && s[pos] == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool peek(char c) { skipSpace(); return pos < s.size() && s[pos] == c; }
+
+    bool consumeWord(const char* word) {
+        std::string_view w(word);
+        if (s.substr(pos, w.size()) == w) {
+            pos += w.size();
+            return true;
+        }
+        return false;
+    }
+
+    bool hex4(unsigned long& value) {
+        if (pos + 4 > s.size()) return false;
+        value = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = s[pos++];
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+            else return false;
+        }
+        return true;
+    }
+
+    bool string(std::string& out, std::string& error) {
+        if (!consume('"')) {
+            error = "expected string";
+            return false;
+        }
+        out.clear();
+        while (pos < s.size()) {
+            char c = s[pos++];
+            if (c == '"') return true;
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos >= s.size()) break;
+            char e = s[pos++];
+            switch (e) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                unsigned long cp;
+                if (!hex4(cp)) {
+                    error = "bad \\u escape";
+                    return false;
+                }
+                // Surrogate pair
+                if (cp >= 0xd800 && cp < 0xdc00 && consumeWord("\\u")) {
+                    unsigned long low;
+                    if (!hex4(low) || low < 0xdc00 || low > 0xdfff) {
+                        error = "bad surrogate pair";
+                        return false;
+                    }
+                    cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+                }
+                appendUtf8(out, cp);
+                break;
+            }
+            default:
+                error = "bad escape";
+                return false;
+            }
+        }
+        error = "unterminated string";
+        return false;
+    }
+
+    // Scalar value as text; returns false for objects/arrays or bad tokens.
+    // present is false for null.
+    bool value(std::string& out, bool& present, std::string& error) {
+        skipSpace();
+        present = true;
+        if (peek('"')) return string(out, error);
+        if (consumeWord("true")) { out = "1"; return true; }
+        if (consumeWord("false")) { out = "0"; return true; }
+        if (consumeWord("null")) { present = false; return true; }
+        if (peek('{') || peek('[')) {
+            error = "nested objects and arrays are not supported";
+            return false;
+        }
+        size_t start = pos;
+        while (pos < s.size() && (std::isdigit(static_cast<unsigned char>(s[pos])) ||
+                                  s[pos] == '-' || s[pos] == '+' || s[pos] == '.' ||
+                                  s[pos] == 'e' || s[pos] == 'E')) {
+            ++pos;
+        }
+        if (pos == start) {
+            error = "unexpected character";
+            return false;
+        }
+        out.assign(s.data() + start, pos - start);
+        return true;
+    }
+};
+
+bool parseDouble(const std::string& text, double& value) {
+    if (text.empty()) return false;
+    char* end;
+    errno = 0;
+    value = std::strtod(text.c_str(), &end);
+    return errno == 0 && *end == '\0';
+}
+
+bool parseInt(const std::string& text, int& value) {
+    if (text.empty()) return false;
+    char* end;
+    errno = 0;
+    long v = std::strtol(text.c_str(), &end, 10);
+    if (errno != 0 || *end != '\0' || v < -2147483647L - 1 || v > 2147483647L) return false;
+    value = static_cast<int>(v);
+    return true;
+}
+
+bool parseBool(const std::string& text, bool& value) {
+    if (text == "1" || text == "true") { value = true; return true; }
+    if (text == "0" || text == "false" || text.empty()) { value = false; return true; }
+    return false;
+}
+
+// "YYYY-MM-DD HH:MM:SS", the form SQLite's CURRENT_TIMESTAMP stores and the
+// list order compares as text.
+bool isTimestamp(const std::string& text) {
+    static const char kPattern[] = "dddd-dd-dd dd:dd:dd";
+    if (text.size() != sizeof(kPattern) - 1) return false;
+    for (size_t i = 0; i < text.size(); ++i) {
+        bool digit = std::isdigit(static_cast<unsigned char>(text[i])) != 0;
+        if (kPattern[i] == 'd' ? !digit : text[i] != kPattern[i]) return false;
+    }
+    return true;
+}
+
+}
+
+bool parseJsonFields(std::string_view line, ImportFields& fields, std::string& error) {
+    fields.clear();
+    JsonScanner scanner(line);
+
+    if (!scanner.consume('{')) {
+        error = "expected a JSON object";
+        return false;
+    }
+    std::string key, value;
+    while (!scanner.consume('}')) {
+        bool present;
+        if (!scanner.string(key, error)) return false;
+        if (!scanner.consume(':')) {
+            error = "expected ':'";
+            return false;
+        }
+        if (!scanner.value(value, present, error)) {
+            error = "field '" + key + "': " + error;
+            return false;
+        }
+        if (present) {
+            fields.emplace_back(key, value);
+        }
+        if (!scanner.consume(',') && !scanner.peek('}')) {
+            error = "expected ',' or '}'";
+            return false;
+        }
+    }
+
+    if (!scanner.atEnd()) {
+        error = "trailing characters after object";
+        return false;
+    }
+    return true;
+}
+
+bool parseCsvRecord(std::string_view record, std::vector<std::string>& values, std::string& error) {
+    values.clear();
+    values.emplace_back();
+
+    bool quoted = false;
+    for (size_t i = 0; i < record.size(); ++i) {
+        char c = record[i];
+        if (quoted) {
+            if (c == '"') {
+                if (i + 1 < record.size() && record[i + 1] == '"') {
+                    values.back() += '"';
+                    ++i;
+                } else {
+                    quoted = false;
+                }
+            } else {
+                values.back() += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            values.emplace_back();
+        } else {
+            values.back() += c;
+        }
+    }
+
+    if (quoted) {
+        error = "unterminated quoted field";
+        return false;
+    }
+    return true;
+}
+
+bool recipeFromFields(const ImportFields& fields, Recipe& recipe, std::string& error) {
+    recipe = Recipe();
+    recipe.id = -1;
+    recipe.protein = 0;
+    recipe.carbs = 0;
+    recipe.is_vegan = false;
+    recipe.is_vegetarian = false;
+    recipe.is_gluten_free = false;
+    recipe.cook_time = 0;
+    recipe.difficulty = Difficulty::Medium;
+
+    for (const auto& field : fields) {
+        const std::string& name = field.first;
+        const std::string& value = field.second;
+        bool ok = true;
+
+        if (name == "title") recipe.title = value;
+        else if (name == "description") recipe.description = value;
+        else if (name == "image_url") recipe.image_url = value;
+        else if (name == "ingredients") recipe.ingredients = value;
+        else if (name == "instructions") recipe.instructions = value;
+        else if (name == "protein") ok = parseDouble(value, recipe.protein) && recipe.protein >= 0;
+        else if (name == "carbs") ok = parseDouble(value, recipe.carbs) && recipe.carbs >= 0;
+        else if (name == "cook_time") ok = parseInt(value, recipe.cook_time) && recipe.cook_time >= 0;
+        else if (name == "is_vegan") ok = parseBool(value, recipe.is_vegan);
+        else if (name == "is_vegetarian") ok = parseBool(value, recipe.is_vegetarian);
+        else if (name == "is_gluten_free") ok = parseBool(value, recipe.is_gluten_free);
+        else if (name == "created_at") {
+            recipe.created_at = value;
+            ok = value.empty() || isTimestamp(value);
+        }
+        else if (name == "difficulty") {
+            if (value == "easy" || value == "1") recipe.difficulty = Difficulty::Easy;
+            else if (value == "medium" || value == "2") recipe.difficulty = Difficulty::Medium;
+            else if (value == "hard" || value == "3") recipe.difficulty = Difficulty::Hard;
+            else ok = false;
+        }
+
+        if (!ok) {
+            error = "invalid " + name + ": '" + value + "'";
+            return false;
+        }
+    }
+
+    if (recipe.title.empty()) error = "missing title";
+    else if (recipe.description.empty()) error = "missing description";
+    else if (recipe.ingredients.empty()) error = "missing ingredients";
+    else if (recipe.instructions.empty()) error = "missing instructions";
+    else return true;
+    return false;
+}
+
+RecipeImportParser::RecipeImportParser(ImportFormat format, RecipeHandler onRecipe, ErrorHandler onError)
+    : format(format), onRecipe(std::move(onRecipe)), onError(std::move(onError)),
+      line(1), recordLine(1), inQuotes(false), oversized(false) {}
+
+void RecipeImportParser::feed(const char* data, size_t length) {
+    if (oversized) {
+        return;
+    }
+    size_t start = 0;
+    for (size_t i = 0; i < length; ++i) {
+        char c = data[i];
+        if (c == '"' && format == ImportFormat::Csv) {
+            inQuotes = !inQuotes;
+        } else if (c == '\n') {
+            ++line;
+            if (inQuotes) continue;
+
+            if (pending.size() + (i - start) > kMaxRecordBytes) {
+                oversized = true;
+                return;
+            }
+            // Whole records inside this chunk are parsed in place; only a
+            // record straddling chunks goes through `pending`.
+            if (pending.empty()) {
+                handleRecord(std::string_view(data + start, i - start));
+            } else {
+                pending.append(data + start, i - start);
+                handleRecord(pending);
+                pending.clear();
+            }
+            start = i + 1;
+            recordLine = line;
+        }
+    }
+    if (pending.size() + (length - start) > kMaxRecordBytes) {
+        oversized = true;
+        return;
+    }
+    pending.append(data + start, length - start);
+}
+
+void RecipeImportParser::finish() {
+    if (!pending.empty() && !oversized) {
+        handleRecord(pending);
+        pending.clear();
+    }
+}
+
+void RecipeImportParser::handleRecord(std::string_view record) {
+    if (!record.empty() && record.back() == '\r') {
+        record.remove_suffix(1);
+    }
+    if (record.find_first_not_of(" \t") == std::string_view::npos) {
+        return;
+    }
+
+    std::string error;
+    if (format == ImportFormat::Ndjson) {
+        if (!parseJsonFields(record, fields, error)) {
+            onError(recordLine, error);
+            return;
+        }
+    } else {
+        std::vector<std::string> values;
+        if (!parseCsvRecord(record, values, error)) {
+            onError(recordLine, error);
+            return;
+        }
+        if (csvHeader.empty()) {
+            csvHeader = std::move(values);
+            return;
+        }
+        if (values.size() != csvHeader.size()) {
+            onError(recordLine, "expected " + std::to_string(csvHeader.size()) + " fields, got " +
+                                    std::to_string(values.size()));
+            return;
+        }
+        fields.clear();
+        for (size_t i = 0; i < values.size(); ++i) {
+            fields.emplace_back(csvHeader[i], std::move(values[i]));
+        }
+    }
+
+    Recipe recipe;
+    if (!recipeFromFields(fields, recipe, error)) {
+        onError(recordLine, error);
+        return;
+    }
+    onRecipe(recordLine, recipe);
+}
+
+namespace {
+
+std::string_view trimmed(std::string_view s) {
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front()))) s.remove_prefix(1);
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back()))) s.remove_suffix(1);
+    return s;
+}
+
+// Strips `open`, then `close` from the ends of `s` and the whitespace inside them.
+bool unwrap(std::string_view& s, char open, char close) {
+    if (s.size() < 2 || s.front() != open || s.back() != close) {
+        return false;
+    }
+    s = trimmed(s.substr(1, s.size() - 2));
+    return true;
+}
+
+}  // namespace
+
+bool parseIdList(const std::string& text, std::vector<int>& ids) {
+    ids.clear();
+    std::string_view list = trimmed(text);
+    if (unwrap(list, '{', '}')) {
+        const std::string_view key = "\"ids\"";
+        if (list.substr(0, key.size()) != key) {
+            return false;
+        }
+        list = trimmed(list.substr(key.size()));
+        if (list.empty() || list.front() != ':') {
+            return false;
+        }
+        list = trimmed(list.substr(1));
+        if (!unwrap(list, '[', ']')) {
+            return false;
+        }
+    } else {
+        unwrap(list, '[', ']');
+    }
+    if (list.empty()) {
+        return true;
+    }
+
+    // Split by hand: getline would silently drop a trailing empty item.
+    // Whitespace is only allowed around an item, so "1 2" is not read as 12.
+    size_t start = 0;
+    for (;;) {
+        size_t end = list.find(',', start);
+        std::string_view item = trimmed(list.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start));
+        if (item.empty() || item.size() > 9 || item.find_first_not_of("0123456789") != std::string_view::npos) {
+            return false;
+        }
+        ids.push_back(std::stoi(std::string(item)));
+        if (end == std::string_view::npos) {
+            return true;
+        }
+        start = end + 1;
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef RECIPE_IMPORT_H
+#define RECIPE_IMPORT_H
+
+#include "recipe.h"
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+enum class ImportFormat {
+    Ndjson, // one flat JSON object per line
+    Csv     // RFC 4180; the first record is a header naming the columns
+};
+
+using ImportFields = std::vector<std::pair<std::string, std::string>>;
+
+// Incremental parser for bulk uploads. feed() takes the body in arbitrary
+// chunks as they come off the socket; each complete record is validated and
+// handed to onRecipe, or reported to onError with its 1-based line number.
+// Only the unfinished tail of the last chunk is buffered, up to
+// kMaxRecordBytes; a longer record stops the parse (see oversizedLine()).
+class RecipeImportParser {
+public:
+    using RecipeHandler = std::function<void(size_t line, const Recipe& recipe)>;
+    using ErrorHandler = std::function<void(size_t line, const std::string& message)>;
+
+    static const size_t kMaxRecordBytes = 1024 * 1024;
+
+private:
+    ImportFormat format;
+    RecipeHandler onRecipe;
+    ErrorHandler onError;
+
+    std::string pending;
+    size_t line;         // physical line the scanner is on
+    size_t recordLine;   // line the pending record started on
+    bool inQuotes;       // CSV only: newlines inside quotes don't end a record
+    bool oversized;      // a record outgrew kMaxRecordBytes; input is ignored from there
+    std::vector<std::string> csvHeader;
+    ImportFields fields;
+
+    void handleRecord(std::string_view record);
+
+public:
+    RecipeImportParser(ImportFormat format, RecipeHandler onRecipe, ErrorHandler onError);
+
+    void feed(const char* data, size_t length);
+    // Flushes a final record that isn't newline-terminated.
+    void finish();
+
+    // Line of the record that exceeded kMaxRecordBytes, or 0 if none did.
+    size_t oversizedLine() const { return oversized ? recordLine : 0; }
+};
+
+// Parses one NDJSON line. Values must be strings, numbers, booleans or null;
+// strings are unescaped, numbers keep their text, booleans become "1"/"0"
+// and null fields are dropped.
+bool parseJsonFields(std::string_view line, ImportFields& fields, std::string& error);
+
+// Splits one CSV record (which may contain quoted newlines) into fields.
+bool parseCsvRecord(std::string_view record, std::vector<std::string>& values, std::string& error);
+
+// Validates named fields and builds a Recipe. title, description,
+// ingredients and instructions are required. created_at is kept when given
+// as "YYYY-MM-DD HH:MM:SS" (as exported), so a re-import preserves the list
+// order; unknown names (such as id from an export) are ignored.
+bool recipeFromFields(const ImportFields& fields, Recipe& recipe, std::string& error);
+
+// Reads a batch id list: "1,2,3", a JSON array, or {"ids": [...]}. Every
+// item must be a non-negative integer of at most 9 digits, optionally
+// surrounded by whitespace; an empty item anywhere ("1,,2", "1,2,") or
+// whitespace inside one ("1 2") rejects the list. An empty list is valid.
+// ids is cleared first.
+bool parseIdList(const std::string& text, std::vector<int>& ids);
+
+#endif
@@ -0,0 +1,143 @@
+#include "request_queue.h"
+#include <atomic>
+
+namespace {
+
+thread_local std::chrono::steady_clock::duration pendingQueueTime{};
+thread_local bool onOverflowThread = false;
+thread_local ExpensiveGate* heldGate = nullptr;
+
+std::atomic<size_t> queuedConnections(0);
+
+}
+
+RequestQueue::RequestQueue(const RequestQueueSettings& settings)
+    : maxQueued(settings.maxQueued), maxOverflow(settings.maxOverflow), stopping(false) {
+    for (int i = 0; i < settings.workers; ++i) {
+        threads.emplace_back(&RequestQueue::runWorker, this);
+    }
+    for (int i = 0; i < settings.overflowThreads; ++i) {
+        threads.emplace_back(&RequestQueue::runOverflow, this);
+    }
+}
+
+RequestQueue::~RequestQueue() {
+    shutdown();
+}
+
+bool RequestQueue::enqueue(std::function<void()> fn) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            return false;
+        }
+        if (jobs.size() < maxQueued) {
+            jobs.push_back(Job{std::move(fn), Clock::now()});
+            queuedConnections.fetch_add(1, std::memory_order_relaxed);
+            ready.notify_one();
+            return true;
+        }
+        if (overflow.size() >= maxOverflow) {
+            return false;
+        }
+        overflow.push_back(Job{std::move(fn), Clock::now()});
+    }
+    overflowReady.notify_one();
+    return true;
+}
+
+void RequestQueue::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping && threads.empty()) {
+            return;
+        }
+        stopping = true;
+    }
+    ready.notify_all();
+    overflowReady.notify_all();
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    threads.clear();
+}
+
+void RequestQueue::runWorker() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (jobs.empty()) {
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        queuedConnections.fetch_sub(1, std::memory_order_relaxed);
+
+        pendingQueueTime = Clock::now() - job.queuedAt;
+        job.fn();
+        pendingQueueTime = Clock::duration::zero();
+        ExpensiveGate::releaseHeld();
+    }
+}
+
+void RequestQueue::runOverflow() {
+    onOverflowThread = true;
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            overflowReady.wait(lock, [this] { return stopping || !overflow.empty(); });
+            if (overflow.empty()) {
+                return;
+            }
+            job = std::move(overflow.front());
+            overflow.pop_front();
+        }
+        job.fn();
+    }
+}
+
+RequestQueue::Clock::duration RequestQueue::takeQueueTime() {
+    Clock::duration waited = pendingQueueTime;
+    pendingQueueTime = Clock::duration::zero();
+    return waited;
+}
+
+bool RequestQueue::overflowing() {
+    return onOverflowThread;
+}
+
+size_t RequestQueue::depth() {
+    return queuedConnections.load(std::memory_order_relaxed);
+}
+
+ExpensiveGate::ExpensiveGate(int slots) : slots(slots > 0 ? slots : 1), inUse(0) {}
+
+bool ExpensiveGate::enter(std::chrono::milliseconds wait) {
+    if (heldGate == this) {
+        return true;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!freed.wait_for(lock, wait, [this] { return inUse < slots; })) {
+        return false;
+    }
+    ++inUse;
+    heldGate = this;
+    return true;
+}
+
+void ExpensiveGate::releaseHeld() {
+    ExpensiveGate* gate = heldGate;
+    if (!gate) {
+        return;
+    }
+    heldGate = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(gate->mutex);
+        --gate->inUse;
+    }
+    gate->freed.notify_one();
+}
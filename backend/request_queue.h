@@ -0,0 +1,91 @@
+#ifndef REQUEST_QUEUE_H
+#define REQUEST_QUEUE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct RequestQueueSettings {
+    int workers = 32;
+    size_t maxQueued = 256;   // connections waiting for a worker
+    int overflowThreads = 2;  // threads that answer 503 past maxQueued
+    size_t maxOverflow = 64;  // beyond this, connections are closed unanswered
+};
+
+// Bounded queue of accepted connections feeding a fixed pool of workers
+// (the server's TaskQueue). Each job records when it was queued, so the
+// worker can report how long the connection waited. Once maxQueued
+// connections are waiting, new ones go to a couple of overflow threads
+// whose requests are answered with 503 (see overflowing()) instead of
+// queueing without bound; only when those fall behind too is a connection
+// dropped outright. maxQueued bounds memory; the server also sheds requests
+// whose recorded wait (takeQueueTime()) exceeded its max_queue_wait_ms.
+class RequestQueue {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Job {
+        std::function<void()> fn;
+        Clock::time_point queuedAt;
+    };
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::condition_variable overflowReady;
+    std::deque<Job> jobs;
+    std::deque<Job> overflow;
+    size_t maxQueued;
+    size_t maxOverflow;
+    bool stopping;
+    std::vector<std::thread> threads;
+
+    void runWorker();
+    void runOverflow();
+
+public:
+    explicit RequestQueue(const RequestQueueSettings& settings);
+    ~RequestQueue();
+    RequestQueue(const RequestQueue&) = delete;
+    RequestQueue& operator=(const RequestQueue&) = delete;
+
+    // False if the connection should be closed without a response.
+    bool enqueue(std::function<void()> fn);
+    // Lets queued jobs finish, then joins the threads.
+    void shutdown();
+
+    // Time the connection being served on this thread spent queued. Only
+    // the first request on a connection waited, so later calls return zero.
+    static Clock::duration takeQueueTime();
+    // True on overflow threads: requests there should get a 503.
+    static bool overflowing();
+    // Connections currently waiting for a worker, across all queues.
+    static size_t depth();
+};
+
+// Caps how many expensive requests (full lists, filters, exports, bulk
+// imports) run at once so cheap ones (single recipes, top-K pages, static
+// files) always find a free worker. A slot is held from admission until the
+// response is written, or at the latest until the worker finishes the
+// connection.
+class ExpensiveGate {
+private:
+    std::mutex mutex;
+    std::condition_variable freed;
+    int slots;
+    int inUse;
+
+public:
+    explicit ExpensiveGate(int slots);
+
+    // Waits up to `wait` for a slot; false if none freed up in time.
+    bool enter(std::chrono::milliseconds wait);
+    // Frees the slot held by this thread, if any.
+    static void releaseHeld();
+};
+
+#endif
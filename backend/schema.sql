@@ -1,3 +1,11 @@
+CREATE TABLE IF NOT EXISTS difficulties (
+    rank INTEGER PRIMARY KEY,
+    name TEXT NOT NULL UNIQUE
+);
+
+INSERT OR IGNORE INTO difficulties (rank, name) VALUES
+(1, 'easy'), (2, 'medium'), (3, 'hard');
+
 CREATE TABLE IF NOT EXISTS recipes (
     id INTEGER PRIMARY KEY AUTOINCREMENT,
     title TEXT NOT NULL,
@@ -9,13 +17,30 @@ CREATE TABLE IF NOT EXISTS recipes (
     is_vegetarian INTEGER DEFAULT 0,
     is_gluten_free INTEGER DEFAULT 0,
     cook_time INTEGER DEFAULT 0,
-    difficulty TEXT DEFAULT 'medium',
+    difficulty INTEGER NOT NULL DEFAULT 2 REFERENCES difficulties(rank),
     ingredients TEXT NOT NULL,
     instructions TEXT NOT NULL,
-    created_at DATETIME DEFAULT CURRENT_TIMESTAMP
+    created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+    version INTEGER NOT NULL DEFAULT 1,
+    change_seq INTEGER NOT NULL DEFAULT 0
+);
+
+CREATE INDEX IF NOT EXISTS idx_recipes_cook_time ON recipes(cook_time);
+CREATE INDEX IF NOT EXISTS idx_recipes_difficulty ON recipes(difficulty);
+CREATE INDEX IF NOT EXISTS idx_recipes_created_at ON recipes(created_at);
+CREATE INDEX IF NOT EXISTS idx_recipes_change_seq ON recipes(change_seq);
+
+CREATE TABLE IF NOT EXISTS recipe_tombstones (
+    id INTEGER PRIMARY KEY,
+    version INTEGER NOT NULL,
+    change_seq INTEGER NOT NULL
 );
 
+CREATE INDEX IF NOT EXISTS idx_recipe_tombstones_change_seq ON recipe_tombstones(change_seq);
+
 INSERT INTO recipes (title, description, image_url, protein, carbs, is_vegan, is_vegetarian, is_gluten_free, cook_time, difficulty, ingredients, instructions) VALUES
-('Spinach & Feta Rolls', 'Easy to make and full of flavor, with creamy feta and fresh spinach wrapped in flaky puff pastry. Perfect for a quick snack or a simple meal.', 'sf-scaled.jpg', 12.5, 28.0, 0, 1, 0, 30, 'easy', 'Puff pastry, Spinach (200g), Feta cheese (150g), Olive oil, Garlic (2 cloves), Salt, Pepper', '1. Preheat oven to 200°C\n2. Sauté spinach and garlic in olive oil\n3. Mix with crumbled feta\n4. Roll puff pastry and cut into squares\n5. Add filling and fold\n6. Bake for 25-30 minutes until golden'),
-('Chocolate Chip Cookies', 'A classic, comforting treat. They are soft and chewy with just the right amount of chocolate chips, making them perfect for any time you need a sweet fix.', '21-Chocolate-Chip-Cookie-Recipes-1www-1-of-1.jpg', 4.2, 52.0, 0, 1, 0, 20, 'easy', 'Flour (2 cups), Butter (1 cup), Sugar (3/4 cup), Brown sugar (3/4 cup), Eggs (2), Vanilla extract, Chocolate chips (2 cups), Baking soda, Salt', '1. Preheat oven to 180°C\n2. Cream butter and sugars\n3. Add eggs and vanilla\n4. Mix in flour, baking soda, and salt\n5. Fold in chocolate chips\n6. Bake for 12-15 minutes'),
-('Tiramisu', 'The rich and creamy delight of homemade tiramisu, where layers of espresso-soaked ladyfingers meet velvety mascarpone cheese and a hint of cocoa powder.', 'best-easy-tiramisu-recipe-27-768x1055.jpg', 8.5, 35.0, 0, 1, 0, 45, 'medium', 'Ladyfinger cookies (200g), Mascarpone cheese (500g), Eggs (4), Sugar (100g), Espresso coffee (1 cup), Cocoa powder, Marsala wine (optional)', '1. Brew strong espresso and let cool\n2. Separate egg yolks and whites\n3. Beat yolks with sugar until creamy\n4. Fold in mascarpone\n5. Beat egg whites to stiff peaks and fold in\n6. Dip ladyfingers in espresso\n7. Layer in dish\n8. Refrigerate 4-6 hours\n9. Dust with cocoa before serving');
+('Spinach & Feta Rolls', 'Easy to make and full of flavor, with creamy feta and fresh spinach wrapped in flaky puff pastry. Perfect for a quick snack or a simple meal.', 'sf-scaled.jpg', 12.5, 28.0, 0, 1, 0, 30, 1, 'Puff pastry, Spinach (200g), Feta cheese (150g), Olive oil, Garlic (2 cloves), Salt, Pepper', '1. Preheat oven to 200°C\n2. Sauté spinach and garlic in olive oil\n3. Mix with crumbled feta\n4. Roll puff pastry and cut into squares\n5. Add filling and fold\n6. Bake for 25-30 minutes until golden'),
+('Chocolate Chip Cookies', 'A classic, comforting treat. They are soft and chewy with just the right amount of chocolate chips, making them perfect for any time you need a sweet fix.', '21-Chocolate-Chip-Cookie-Recipes-1www-1-of-1.jpg', 4.2, 52.0, 0, 1, 0, 20, 1, 'Flour (2 cups), Butter (1 cup), Sugar (3/4 cup), Brown sugar (3/4 cup), Eggs (2), Vanilla extract, Chocolate chips (2 cups), Baking soda, Salt', '1. Preheat oven to 180°C\n2. Cream butter and sugars\n3. Add eggs and vanilla\n4. Mix in flour, baking soda, and salt\n5. Fold in chocolate chips\n6. Bake for 12-15 minutes'),
+('Tiramisu', 'The rich and creamy delight of homemade tiramisu, where layers of espresso-soaked ladyfingers meet velvety mascarpone cheese and a hint of cocoa powder.', 'best-easy-tiramisu-recipe-27-768x1055.jpg', 8.5, 35.0, 0, 1, 0, 45, 2, 'Ladyfinger cookies (200g), Mascarpone cheese (500g), Eggs (4), Sugar (100g), Espresso coffee (1 cup), Cocoa powder, Marsala wine (optional)', '1. Brew strong espresso and let cool\n2. Separate egg yolks and whites\n3. Beat yolks with sugar until creamy\n4. Fold in mascarpone\n5. Beat egg whites to stiff peaks and fold in\n6. Dip ladyfingers in espresso\n7. Layer in dish\n8. Refrigerate 4-6 hours\n9. Dust with cocoa before serving');
+
+PRAGMA user_version = 3;
@@ -0,0 +1,453 @@
+#include "serialize.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+
+// JSON escape sequence for every byte value; length 0 means the byte is
+// copied as is. Control characters, '"' and '\\' are the only ones escaped.
+struct JsonEscapes
+{
+    struct Entry
+    {
+        char text[7];
+        uint8_t length;
+    };
+    Entry entries[256];
+
+    JsonEscapes()
+    {
+        static const char hex[] = "0123456789abcdef";
+        for (int c = 0; c < 256; ++c)
+        {
+            Entry &e = entries[c];
+            e.length = 0;
+            if (c < 0x20)
+            {
+                std::memcpy(e.text, "\\u00", 4);
+                e.text[4] = hex[c >> 4];
+                e.text[5] = hex[c & 0xf];
+                e.length = 6;
+            }
+        }
+        const char shortForms[][2] = {{'"', '"'}, {'\\', '\\'}, {'\b', 'b'}, {'\f', 'f'},
+                                      {'\n', 'n'}, {'\r', 'r'}, {'\t', 't'}};
+        for (const auto &form : shortForms)
+        {
+            Entry &e = entries[static_cast<unsigned char>(form[0])];
+            e.text[0] = '\\';
+            e.text[1] = form[1];
+            e.length = 2;
+        }
+    }
+};
+
+const JsonEscapes kJsonEscapes;
+
+void appendNumber(std::string &out, double value)
+{
+    // %g matches what operator<< produced for doubles before
+    char buf[32];
+    int n = std::snprintf(buf, sizeof(buf), "%g", value);
+    out.append(buf, n);
+}
+
+void appendBool(std::string &out, bool value)
+{
+    out += value ? "true" : "false";
+}
+
+void appendStringField(std::string &out, const char *key, std::string_view value)
+{
+    out += key;
+    out += '"';
+    appendJsonEscaped(out, value);
+    out += '"';
+}
+
+// CBOR major types (RFC 8949 section 3.1)
+const uint8_t kCborUnsigned = 0;
+const uint8_t kCborNegative = 1;
+const uint8_t kCborText = 3;
+const uint8_t kCborArray = 4;
+const uint8_t kCborMap = 5;
+const uint8_t kCborFalse = 0xf4;
+const uint8_t kCborTrue = 0xf5;
+const uint8_t kCborFloat64 = 0xfb;
+const uint8_t kCborIndefiniteArray = 0x9f;
+const uint8_t kCborBreak = 0xff;
+
+void appendCborHead(std::string &out, uint8_t major, uint64_t value)
+{
+    uint8_t type = static_cast<uint8_t>(major << 5);
+    if (value < 24)
+    {
+        out += static_cast<char>(type | value);
+        return;
+    }
+
+    int bytes;
+    if (value <= 0xff)
+    {
+        out += static_cast<char>(type | 24);
+        bytes = 1;
+    }
+    else if (value <= 0xffff)
+    {
+        out += static_cast<char>(type | 25);
+        bytes = 2;
+    }
+    else if (value <= 0xffffffffULL)
+    {
+        out += static_cast<char>(type | 26);
+        bytes = 4;
+    }
+    else
+    {
+        out += static_cast<char>(type | 27);
+        bytes = 8;
+    }
+    for (int i = bytes - 1; i >= 0; --i)
+        out += static_cast<char>((value >> (8 * i)) & 0xff);
+}
+
+void appendCborText(std::string &out, std::string_view s)
+{
+    appendCborHead(out, kCborText, s.size());
+    out.append(s.data(), s.size());
+}
+
+void appendCborInt(std::string &out, int64_t value)
+{
+    if (value >= 0)
+        appendCborHead(out, kCborUnsigned, static_cast<uint64_t>(value));
+    else
+        appendCborHead(out, kCborNegative, static_cast<uint64_t>(-1 - value));
+}
+
+void appendCborDouble(std::string &out, double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    out += static_cast<char>(kCborFloat64);
+    for (int i = 7; i >= 0; --i)
+        out += static_cast<char>((bits >> (8 * i)) & 0xff);
+}
+
+void appendCborBool(std::string &out, bool value)
+{
+    out += static_cast<char>(value ? kCborTrue : kCborFalse);
+}
+
+const char kCsvHeader[] = "id,title,description,image_url,protein,carbs,is_vegan,is_vegetarian,"
+                          "is_gluten_free,cook_time,difficulty,ingredients,instructions,created_at\r\n";
+
+void appendCsvField(std::string &out, std::string_view value)
+{
+    if (value.find_first_of(",\"\r\n") == std::string_view::npos)
+    {
+        out.append(value.data(), value.size());
+        return;
+    }
+    out += '"';
+    for (char c : value)
+    {
+        if (c == '"')
+            out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+class JsonSerializer : public RecipeSerializer
+{
+public:
+    const char *contentType() const override { return "application/json"; }
+    void appendRecipe(std::string &out, const RecipeView &recipe) const override
+    {
+        appendRecipeJson(out, recipe);
+    }
+    void beginList(std::string &out) const override { out += '['; }
+    void appendItem(std::string &out, const RecipeView &recipe, bool first) const override
+    {
+        if (!first)
+            out += ',';
+        appendRecipeJson(out, recipe);
+    }
+    void endList(std::string &out) const override { out += ']'; }
+};
+
+class NdjsonSerializer : public RecipeSerializer
+{
+public:
+    const char *contentType() const override { return "application/x-ndjson"; }
+    void appendRecipe(std::string &out, const RecipeView &recipe) const override
+    {
+        appendRecipeJson(out, recipe);
+        out += '\n';
+    }
+    void beginList(std::string &) const override {}
+    void appendItem(std::string &out, const RecipeView &recipe, bool) const override
+    {
+        appendRecipe(out, recipe);
+    }
+    void endList(std::string &) const override {}
+};
+
+class CborSerializer : public RecipeSerializer
+{
+public:
+    const char *contentType() const override { return "application/cbor"; }
+    void appendRecipe(std::string &out, const RecipeView &recipe) const override
+    {
+        appendRecipeCbor(out, recipe);
+    }
+    void beginList(std::string &out) const override
+    {
+        out += static_cast<char>(kCborIndefiniteArray);
+    }
+    void appendItem(std::string &out, const RecipeView &recipe, bool) const override
+    {
+        appendRecipeCbor(out, recipe);
+    }
+    void endList(std::string &out) const override { out += static_cast<char>(kCborBreak); }
+};
+
+class CsvSerializer : public RecipeSerializer
+{
+public:
+    const char *contentType() const override { return "text/csv"; }
+    void appendRecipe(std::string &out, const RecipeView &recipe) const override
+    {
+        out += kCsvHeader;
+        appendRecipeCsv(out, recipe);
+    }
+    void beginList(std::string &out) const override { out += kCsvHeader; }
+    void appendItem(std::string &out, const RecipeView &recipe, bool) const override
+    {
+        appendRecipeCsv(out, recipe);
+    }
+    void endList(std::string &) const override {}
+};
+
+}
+
+void appendJsonEscaped(std::string &out, std::string_view s)
+{
+    // Nearly all recipe text needs no escaping, so copy each run of safe
+    // bytes (including UTF-8 sequences) with one append instead of a char
+    // at a time.
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(s.data());
+    const unsigned char *end = p + s.size();
+    while (p < end)
+    {
+        const unsigned char *run = p;
+        while (p < end && kJsonEscapes.entries[*p].length == 0)
+            ++p;
+        if (p > run)
+            out.append(reinterpret_cast<const char *>(run), p - run);
+        if (p == end)
+            break;
+
+        const JsonEscapes::Entry &escape = kJsonEscapes.entries[*p++];
+        out.append(escape.text, escape.length);
+    }
+}
+
+void appendRecipeJson(std::string &out, const RecipeView &recipe)
+{
+    out += "{\"id\":";
+    out += std::to_string(recipe.id);
+    appendStringField(out, ",\"title\":", recipe.title);
+    appendStringField(out, ",\"description\":", recipe.description);
+    appendStringField(out, ",\"image_url\":", recipe.image_url);
+    out += ",\"protein\":";
+    appendNumber(out, recipe.protein);
+    out += ",\"carbs\":";
+    appendNumber(out, recipe.carbs);
+    out += ",\"is_vegan\":";
+    appendBool(out, recipe.is_vegan);
+    out += ",\"is_vegetarian\":";
+    appendBool(out, recipe.is_vegetarian);
+    out += ",\"is_gluten_free\":";
+    appendBool(out, recipe.is_gluten_free);
+    out += ",\"cook_time\":";
+    out += std::to_string(recipe.cook_time);
+    appendStringField(out, ",\"difficulty\":", difficultyToString(recipe.difficulty));
+    appendStringField(out, ",\"ingredients\":", recipe.ingredients);
+    appendStringField(out, ",\"instructions\":", recipe.instructions);
+    appendStringField(out, ",\"created_at\":", recipe.created_at);
+    out += '}';
+}
+
+std::string jsonEscape(std::string_view s)
+{
+    std::string escaped;
+    escaped.reserve(s.size());
+    appendJsonEscaped(escaped, s);
+    return escaped;
+}
+
+std::string recipeToJson(const Recipe &recipe)
+{
+    return recipeToJson(viewOf(recipe));
+}
+
+std::string recipeToJson(const RecipeView &recipe)
+{
+    std::string out;
+    appendRecipeJson(out, recipe);
+    return out;
+}
+
+std::string recipesToJson(RecipeCursor &cursor)
+{
+    std::string out = "[";
+    cursor.forEach([&](const RecipeView &recipe)
+                   {
+        if (out.size() > 1)
+            out += ',';
+        appendRecipeJson(out, recipe); });
+    out += ']';
+    return out;
+}
+
+void appendRecipeCbor(std::string &out, const RecipeView &recipe)
+{
+    // Same keys and value types as the JSON form
+    appendCborHead(out, kCborMap, 14);
+    appendCborText(out, "id");
+    appendCborInt(out, recipe.id);
+    appendCborText(out, "title");
+    appendCborText(out, recipe.title);
+    appendCborText(out, "description");
+    appendCborText(out, recipe.description);
+    appendCborText(out, "image_url");
+    appendCborText(out, recipe.image_url);
+    appendCborText(out, "protein");
+    appendCborDouble(out, recipe.protein);
+    appendCborText(out, "carbs");
+    appendCborDouble(out, recipe.carbs);
+    appendCborText(out, "is_vegan");
+    appendCborBool(out, recipe.is_vegan);
+    appendCborText(out, "is_vegetarian");
+    appendCborBool(out, recipe.is_vegetarian);
+    appendCborText(out, "is_gluten_free");
+    appendCborBool(out, recipe.is_gluten_free);
+    appendCborText(out, "cook_time");
+    appendCborInt(out, recipe.cook_time);
+    appendCborText(out, "difficulty");
+    appendCborText(out, difficultyToString(recipe.difficulty));
+    appendCborText(out, "ingredients");
+    appendCborText(out, recipe.ingredients);
+    appendCborText(out, "instructions");
+    appendCborText(out, recipe.instructions);
+    appendCborText(out, "created_at");
+    appendCborText(out, recipe.created_at);
+}
+
+void appendRecipeCsv(std::string &out, const RecipeView &recipe)
+{
+    out += std::to_string(recipe.id);
+    out += ',';
+    appendCsvField(out, recipe.title);
+    out += ',';
+    appendCsvField(out, recipe.description);
+    out += ',';
+    appendCsvField(out, recipe.image_url);
+    out += ',';
+    appendNumber(out, recipe.protein);
+    out += ',';
+    appendNumber(out, recipe.carbs);
+    out += recipe.is_vegan ? ",1" : ",0";
+    out += recipe.is_vegetarian ? ",1" : ",0";
+    out += recipe.is_gluten_free ? ",1" : ",0";
+    out += ',';
+    out += std::to_string(recipe.cook_time);
+    out += ',';
+    out += difficultyToString(recipe.difficulty);
+    out += ',';
+    appendCsvField(out, recipe.ingredients);
+    out += ',';
+    appendCsvField(out, recipe.instructions);
+    out += ',';
+    appendCsvField(out, recipe.created_at);
+    out += "\r\n";
+}
+
+const RecipeSerializer &serializerFor(RecipeFormat format)
+{
+    static const JsonSerializer json;
+    static const NdjsonSerializer ndjson;
+    static const CborSerializer cbor;
+    static const CsvSerializer csv;
+
+    switch (format)
+    {
+    case RecipeFormat::Csv:
+        return csv;
+    case RecipeFormat::Ndjson:
+        return ndjson;
+    case RecipeFormat::Cbor:
+        return cbor;
+    default:
+        return json;
+    }
+}
+
+RecipeFormat negotiateRecipeFormat(const std::string &accept)
+{
+    // Media ranges are taken in the order the client listed them; q=0
+    // ("not acceptable") ranges are skipped, other q-values aren't weighed.
+    size_t pos = 0;
+    while (pos < accept.size())
+    {
+        size_t end = accept.find(',', pos);
+        if (end == std::string::npos)
+            end = accept.size();
+
+        std::string range = accept.substr(pos, end - pos);
+        pos = end + 1;
+
+        size_t params = range.find(';');
+        std::string type = range.substr(0, params);
+        type.erase(0, type.find_first_not_of(" \t"));
+        type.erase(type.find_last_not_of(" \t") + 1);
+
+        if (params != std::string::npos)
+        {
+            std::string rest = range.substr(params);
+            rest.erase(std::remove(rest.begin(), rest.end(), ' '), rest.end());
+            if (rest.find(";q=0") == 0 && rest.find_first_not_of("0.", 3) == std::string::npos)
+                continue;
+        }
+
+        if (type == "application/json")
+            return RecipeFormat::Json;
+        if (type == "application/x-ndjson" || type == "application/ndjson" || type == "application/jsonl")
+            return RecipeFormat::Ndjson;
+        if (type == "application/cbor")
+            return RecipeFormat::Cbor;
+        if (type == "text/csv")
+            return RecipeFormat::Csv;
+    }
+    return RecipeFormat::Json;
+}
+
+bool parseRecipeFormat(const std::string &name, RecipeFormat &format)
+{
+    if (name == "json")
+        format = RecipeFormat::Json;
+    else if (name == "ndjson")
+        format = RecipeFormat::Ndjson;
+    else if (name == "cbor")
+        format = RecipeFormat::Cbor;
+    else if (name == "csv")
+        format = RecipeFormat::Csv;
+    else
+        return false;
+    return true;
+}
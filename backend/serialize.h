@@ -0,0 +1,59 @@
+#ifndef SERIALIZE_H
+#define SERIALIZE_H
+
+#include "recipe.h"
+#include "recipe_cursor.h"
+#include <string>
+#include <string_view>
+
+// Appends s to out with JSON string escaping (no surrounding quotes).
+void appendJsonEscaped(std::string &out, std::string_view s);
+
+// Appends one recipe object. This is the single JSON writer; the helpers
+// below all funnel into it.
+void appendRecipeJson(std::string &out, const RecipeView &recipe);
+
+std::string jsonEscape(std::string_view s);
+std::string recipeToJson(const Recipe &recipe);
+std::string recipeToJson(const RecipeView &recipe);
+
+// Serializes rows as they are stepped: each column is copied exactly once,
+// from SQLite's buffer into the JSON output.
+std::string recipesToJson(RecipeCursor &cursor);
+
+enum class RecipeFormat
+{
+    Json,   // application/json: one array
+    Ndjson, // application/x-ndjson: one object per line, no enclosing array
+    Cbor,   // application/cbor (RFC 8949): indefinite-length array of maps
+    Csv     // text/csv (RFC 4180) with a header row; POST /api/recipes/bulk reads it back
+};
+
+// Output framing for one wire format. A list is written as
+// beginList, appendItem per row, endList; all three only append, so a list
+// can be emitted in chunks without knowing the row count up front.
+class RecipeSerializer
+{
+public:
+    virtual ~RecipeSerializer() = default;
+
+    virtual const char *contentType() const = 0;
+    virtual void appendRecipe(std::string &out, const RecipeView &recipe) const = 0;
+    virtual void beginList(std::string &out) const = 0;
+    virtual void appendItem(std::string &out, const RecipeView &recipe, bool first) const = 0;
+    virtual void endList(std::string &out) const = 0;
+};
+
+const RecipeSerializer &serializerFor(RecipeFormat format);
+
+// Picks the format from an Accept header value; anything unrecognised
+// (including */* and a missing header) gets JSON.
+RecipeFormat negotiateRecipeFormat(const std::string &accept);
+
+// Maps a ?format= value ("json", "ndjson", "cbor", "csv").
+bool parseRecipeFormat(const std::string &name, RecipeFormat &format);
+
+void appendRecipeCbor(std::string &out, const RecipeView &recipe);
+void appendRecipeCsv(std::string &out, const RecipeView &recipe);
+
+#endif
@@ -0,0 +1,231 @@
+#include "server_config.h"
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+const char* kDefaultConfigFile = "recipe_server.conf";
+
+bool parseInt(const std::string& value, int& out) {
+    try {
+        size_t used = 0;
+        int parsed = std::stoi(value, &used);
+        if (used != value.size()) {
+            return false;
+        }
+        out = parsed;
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool parseIntInRange(const std::string& value, int min, int max, int& out) {
+    int parsed;
+    if (!parseInt(value, parsed) || parsed < min || parsed > max) {
+        return false;
+    }
+    out = parsed;
+    return true;
+}
+
+std::string describeRange(int min, int max) {
+    if (max == INT_MAX) {
+        return "an integer >= " + std::to_string(min);
+    }
+    return "an integer from " + std::to_string(min) + " to " + std::to_string(max);
+}
+
+bool parseBool(const std::string& value, bool& out) {
+    if (value == "1" || value == "true" || value == "on" || value == "yes") {
+        out = true;
+        return true;
+    }
+    if (value == "0" || value == "false" || value == "off" || value == "no") {
+        out = false;
+        return true;
+    }
+    return false;
+}
+
+std::string trim(const std::string& s) {
+    size_t begin = 0, end = s.size();
+    while (begin < end && std::isspace(static_cast<unsigned char>(s[begin]))) ++begin;
+    while (end > begin && std::isspace(static_cast<unsigned char>(s[end - 1]))) --end;
+    return s.substr(begin, end - begin);
+}
+
+struct Option {
+    const char* key;
+    std::function<bool(ServerConfig&, const std::string&)> set;
+    std::string expected;  // shown when set() rejects a value, if not empty
+};
+
+Option intOption(const char* key, int ServerConfig::*field, int min, int max = INT_MAX) {
+    return {key,
+            [field, min, max](ServerConfig& c, const std::string& v) { return parseIntInRange(v, min, max, c.*field); },
+            describeRange(min, max)};
+}
+
+Option boolOption(const char* key, bool ServerConfig::*field) {
+    return {key, [field](ServerConfig& c, const std::string& v) { return parseBool(v, c.*field); }};
+}
+
+Option stringOption(const char* key, std::string ServerConfig::*field) {
+    return {key, [field](ServerConfig& c, const std::string& v) {
+        c.*field = v;
+        return !v.empty();
+    }};
+}
+
+Option backupIntOption(const char* key, int BackupSettings::*field, int min) {
+    return {key,
+            [field, min](ServerConfig& c, const std::string& v) {
+                return parseIntInRange(v, min, INT_MAX, c.backup.*field);
+            },
+            describeRange(min, INT_MAX)};
+}
+
+const std::vector<Option>& options() {
+    static const std::vector<Option> all = {
+        stringOption("host", &ServerConfig::host),
+        intOption("port", &ServerConfig::port, 1, 65535),
+        stringOption("db_path", &ServerConfig::dbPath),
+        intOption("workers", &ServerConfig::workers, 0),
+        intOption("listen_backlog", &ServerConfig::listenBacklog, 1),
+        intOption("keep_alive_max_count", &ServerConfig::keepAliveMaxCount, 1),
+        intOption("keep_alive_timeout", &ServerConfig::keepAliveTimeoutSeconds, 1),
+        boolOption("tcp_nodelay", &ServerConfig::tcpNoDelay),
+        intOption("read_timeout", &ServerConfig::readTimeoutSeconds, 1),
+        intOption("write_timeout", &ServerConfig::writeTimeoutSeconds, 1),
+        boolOption("event_loop", &ServerConfig::eventLoop),
+        intOption("listeners", &ServerConfig::listeners, 1),
+        boolOption("pin_cpus", &ServerConfig::pinCpus),
+        intOption("max_queued", &ServerConfig::maxQueued, 1),
+        intOption("max_queue_wait_ms", &ServerConfig::maxQueueWaitMs, 0),
+        intOption("expensive_slots", &ServerConfig::expensiveSlots, 1),
+        intOption("expensive_wait_ms", &ServerConfig::expensiveWaitMs, 0),
+        intOption("retry_after", &ServerConfig::retryAfterSeconds, 0),
+        stringOption("rate_limit", &ServerConfig::rateLimit),
+        stringOption("rate_limit_routes", &ServerConfig::rateLimitRoutes),
+        boolOption("materialized_lists", &ServerConfig::materializedLists),
+        intOption("change_feed_max_clients", &ServerConfig::changeFeedMaxClients, 0),
+        intOption("slow_query_ms", &ServerConfig::slowQueryMs, -1),
+        boolOption("timing_log", &ServerConfig::timingLog),
+        {"backup_dir", [](ServerConfig& c, const std::string& v) {
+             c.backup.directory = v;
+             return !v.empty();
+         }},
+        backupIntOption("backup_interval", &BackupSettings::intervalSeconds, 0),
+        backupIntOption("backup_keep", &BackupSettings::keep, 1),
+        backupIntOption("backup_pages_per_step", &BackupSettings::pagesPerStep, 1),
+        backupIntOption("backup_step_pause_ms", &BackupSettings::stepPauseMs, 0),
+    };
+    return all;
+}
+
+bool apply(ServerConfig& config, const std::string& key, const std::string& value, const std::string& source) {
+    for (const Option& option : options()) {
+        if (key == option.key) {
+            if (!option.set(config, value)) {
+                std::cerr << source << ": invalid value for " << key << ": '" << value << "'";
+                if (!option.expected.empty()) {
+                    std::cerr << " (expected " << option.expected << ")";
+                }
+                std::cerr << std::endl;
+                return false;
+            }
+            return true;
+        }
+    }
+    std::cerr << source << ": unknown setting '" << key << "'" << std::endl;
+    return false;
+}
+
+bool loadFile(const std::string& path, bool required, ServerConfig& config) {
+    std::ifstream in(path);
+    if (!in) {
+        if (required) {
+            std::cerr << "Can't read config file " << path << std::endl;
+        }
+        return !required;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) {
+            line.resize(hash);
+        }
+        line = trim(line);
+        if (line.empty()) {
+            continue;
+        }
+        size_t eq = line.find('=');
+        std::string source = path + ":" + std::to_string(lineNumber);
+        if (eq == std::string::npos) {
+            std::cerr << source << ": expected key = value" << std::endl;
+            return false;
+        }
+        if (!apply(config, trim(line.substr(0, eq)), trim(line.substr(eq + 1)), source)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+bool loadServerConfig(int argc, char** argv, ServerConfig& config) {
+    std::string configPath = kDefaultConfigFile;
+    bool configRequired = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 9, "--config=") == 0) {
+            configPath = arg.substr(9);
+            configRequired = true;
+        }
+    }
+    if (!loadFile(configPath, configRequired, config)) {
+        return false;
+    }
+
+    for (const Option& option : options()) {
+        std::string name = "RECIPE_";
+        for (const char* p = option.key; *p; ++p) {
+            name += static_cast<char>(std::toupper(static_cast<unsigned char>(*p)));
+        }
+        const char* value = std::getenv(name.c_str());
+        if (value && *value && !apply(config, option.key, value, name)) {
+            return false;
+        }
+    }
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos) {
+            std::cerr << "Expected --key=value, got '" << arg << "'" << std::endl;
+            return false;
+        }
+        std::string key = arg.substr(2, eq - 2);
+        if (key == "config") {
+            continue;
+        }
+        // Flags use dashes, file and environment keys use underscores
+        for (char& c : key) {
+            if (c == '-') c = '_';
+        }
+        if (!apply(config, key, arg.substr(eq + 1), "command line")) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,54 @@
+#ifndef SERVER_CONFIG_H
+#define SERVER_CONFIG_H
+
+#include "backup.h"
+#include <string>
+
+// Runtime settings for recipe_server. Each key can be given, in increasing
+// order of precedence, in a config file ("key = value" lines, # comments),
+// as an environment variable RECIPE_<KEY> (upper case), or as a --key=value
+// flag. The file is recipe_server.conf if present, or --config=PATH.
+// recipe_server.conf.example documents every key and how the network
+// defaults were chosen.
+struct ServerConfig {
+    std::string host = "0.0.0.0";
+    int port = 8080;
+    std::string dbPath = "recipes.db";
+
+    int workers = 32;                 // request threads; 0 = cpp-httplib's max(8, cores - 1)
+    int listenBacklog = 512;          // pending connections the kernel queues
+    int keepAliveMaxCount = 100;      // requests per connection before closing
+    int keepAliveTimeoutSeconds = 5;  // idle time before a keep-alive closes
+    bool tcpNoDelay = true;           // disable Nagle on client sockets
+    int readTimeoutSeconds = 5;
+    int writeTimeoutSeconds = 5;
+    bool eventLoop = true;            // park idle keep-alive connections in epoll
+    int listeners = 1;                // SO_REUSEPORT accept loops sharing the port
+    bool pinCpus = true;              // with several listeners, split CPUs between them
+
+    int maxQueued = 256;              // connections waiting for a worker before 503s
+    int maxQueueWaitMs = 1000;        // 503 a request that waited longer; 0 = no limit
+    int expensiveSlots = 8;           // concurrent list/filter/export/bulk requests
+    int expensiveWaitMs = 250;        // wait for a slot before answering 503
+    int retryAfterSeconds = 1;        // Retry-After on 503 responses
+
+    std::string rateLimit = "off";    // per client and route, "rate/burst"
+    std::string rateLimitRoutes;      // per-route overrides, "list:5/20,export:1/2"
+
+    bool materializedLists = false;   // keep list orders in memory
+
+    int changeFeedMaxClients = 16;    // concurrent /api/recipes/changes streams
+
+    int slowQueryMs = 100;            // -1 disables the slow-query log
+    bool timingLog = false;           // one logfmt line per request
+
+    BackupSettings backup;
+};
+
+// Fills config from the file, environment and flags. Prints the problem and
+// returns false on an unknown key, a malformed or out-of-range value (each
+// integer has a minimum, e.g. keep_alive_max_count >= 1) or an unreadable
+// --config file.
+bool loadServerConfig(int argc, char** argv, ServerConfig& config);
+
+#endif
@@ -0,0 +1,42 @@
+#include "single_flight.h"
+
+SingleFlight::SingleFlight() : leaders(0), followers(0) {}
+
+SingleFlight::Result SingleFlight::run(const std::string& key, const std::function<Result()>& compute,
+                                       const std::function<void()>& onWait) {
+    std::shared_ptr<Flight> flight;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto it = flights.find(key);
+        if (it != flights.end()) {
+            flight = it->second;
+            followers.fetch_add(1, std::memory_order_relaxed);
+            if (onWait) {
+                lock.unlock();
+                onWait();
+                lock.lock();
+            }
+            finished.wait(lock, [&flight] { return flight->done; });
+            return flight->result;
+        }
+        flight = std::make_shared<Flight>();
+        flights.emplace(key, flight);
+    }
+    leaders.fetch_add(1, std::memory_order_relaxed);
+
+    Result result;
+    try {
+        result = compute();
+    } catch (...) {
+        result = nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        flight->result = result;
+        flight->done = true;
+        flights.erase(key);
+    }
+    finished.notify_all();
+    return result;
+}
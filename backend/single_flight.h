@@ -0,0 +1,46 @@
+#ifndef SINGLE_FLIGHT_H
+#define SINGLE_FLIGHT_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Collapses concurrent identical computations into one. The first caller
+// for a key computes the result; callers arriving while it runs wait and
+// get the same buffer. Nothing is kept once the computation finishes, so
+// this never serves stale data: it only dedupes work that is in flight.
+class SingleFlight {
+public:
+    using Result = std::shared_ptr<const std::string>;
+
+private:
+    struct Flight {
+        bool done = false;
+        Result result;
+    };
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::unordered_map<std::string, std::shared_ptr<Flight>> flights;
+    std::atomic<uint64_t> leaders;
+    std::atomic<uint64_t> followers;
+
+public:
+    SingleFlight();
+
+    // Returns compute()'s result, or that of an identical call already in
+    // flight. onWait runs before a follower blocks (e.g. to give up
+    // resources the leader may need). A null result (failure) is shared too.
+    Result run(const std::string& key, const std::function<Result()>& compute,
+               const std::function<void()>& onWait = nullptr);
+
+    uint64_t leaderCount() const { return leaders.load(std::memory_order_relaxed); }
+    uint64_t followerCount() const { return followers.load(std::memory_order_relaxed); }
+};
+
+#endif
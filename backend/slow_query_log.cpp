@@ -0,0 +1,121 @@
+#include "slow_query_log.h"
+#include "serialize.h"
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <mutex>
+
+namespace {
+
+const size_t kMaxSqlLength = 4096;
+
+std::atomic<int64_t> thresholdNanos(100 * 1000 * 1000);
+
+std::mutex ringMutex;
+SlowQuery ring[SlowQueryLog::kCapacity];
+uint64_t recorded = 0;  // total ever recorded; next slot is recorded % kCapacity
+
+int takeStatus(sqlite3_stmt* stmt, int op) {
+    // Reset so a reused statement reports one execution at a time
+    return sqlite3_stmt_status(stmt, op, 1);
+}
+
+int onTrace(unsigned type, void*, void* p, void* x) {
+    if (type != SQLITE_TRACE_PROFILE) {
+        return 0;
+    }
+    sqlite3_stmt* stmt = static_cast<sqlite3_stmt*>(p);
+    int64_t nanos = static_cast<int64_t>(*static_cast<sqlite3_uint64*>(x));
+    int64_t threshold = thresholdNanos.load(std::memory_order_relaxed);
+    if (threshold < 0 || nanos < threshold) {
+        takeStatus(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP);
+        takeStatus(stmt, SQLITE_STMTSTATUS_SORT);
+        takeStatus(stmt, SQLITE_STMTSTATUS_AUTOINDEX);
+        takeStatus(stmt, SQLITE_STMTSTATUS_VM_STEP);
+        return 0;
+    }
+
+    SlowQuery entry;
+    entry.unixTime = std::time(nullptr);
+    entry.durationMs = nanos / 1e6;
+    if (char* expanded = sqlite3_expanded_sql(stmt)) {
+        entry.sql = expanded;
+        sqlite3_free(expanded);
+    } else if (const char* sql = sqlite3_sql(stmt)) {
+        entry.sql = sql;
+    }
+    if (entry.sql.size() > kMaxSqlLength) {
+        entry.sql.resize(kMaxSqlLength);
+        entry.sql += "...";
+    }
+    entry.fullScanSteps = takeStatus(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP);
+    entry.sorts = takeStatus(stmt, SQLITE_STMTSTATUS_SORT);
+    entry.autoIndexRows = takeStatus(stmt, SQLITE_STMTSTATUS_AUTOINDEX);
+    entry.vmSteps = takeStatus(stmt, SQLITE_STMTSTATUS_VM_STEP);
+
+    std::cerr << "Slow query (" << entry.durationMs << " ms, " << entry.fullScanSteps
+              << " scan steps): " << entry.sql << std::endl;
+
+    std::lock_guard<std::mutex> lock(ringMutex);
+    ring[recorded % SlowQueryLog::kCapacity] = std::move(entry);
+    ++recorded;
+    return 0;
+}
+
+}
+
+void SlowQueryLog::setThresholdMs(double thresholdMs) {
+    thresholdNanos.store(thresholdMs < 0 ? -1 : static_cast<int64_t>(thresholdMs * 1e6), std::memory_order_relaxed);
+}
+
+double SlowQueryLog::thresholdMs() {
+    int64_t nanos = thresholdNanos.load(std::memory_order_relaxed);
+    return nanos < 0 ? -1 : nanos / 1e6;
+}
+
+void SlowQueryLog::attach(sqlite3* db) {
+    sqlite3_trace_v2(db, SQLITE_TRACE_PROFILE, onTrace, nullptr);
+}
+
+std::vector<SlowQuery> SlowQueryLog::entries() {
+    std::lock_guard<std::mutex> lock(ringMutex);
+    size_t count = recorded < kCapacity ? recorded : kCapacity;
+    std::vector<SlowQuery> result;
+    result.reserve(count);
+    for (size_t i = 1; i <= count; ++i) {
+        result.push_back(ring[(recorded - i) % kCapacity]);
+    }
+    return result;
+}
+
+uint64_t SlowQueryLog::totalRecorded() {
+    std::lock_guard<std::mutex> lock(ringMutex);
+    return recorded;
+}
+
+std::string SlowQueryLog::renderJson() {
+    uint64_t total = totalRecorded();
+    std::vector<SlowQuery> queries = entries();
+
+    char buf[64];
+    std::string out = "{\"threshold_ms\":";
+    std::snprintf(buf, sizeof(buf), "%g", thresholdMs());
+    out += buf;
+    out += ",\"total\":" + std::to_string(total) + ",\"queries\":[";
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const SlowQuery& q = queries[i];
+        if (i > 0) out += ",";
+        std::snprintf(buf, sizeof(buf), "%.3f", q.durationMs);
+        out += "{\"time\":" + std::to_string(q.unixTime);
+        out += ",\"duration_ms\":";
+        out += buf;
+        out += ",\"sql\":\"" + jsonEscape(q.sql) + "\"";
+        out += ",\"full_scan_steps\":" + std::to_string(q.fullScanSteps);
+        out += ",\"sorts\":" + std::to_string(q.sorts);
+        out += ",\"auto_index_rows\":" + std::to_string(q.autoIndexRows);
+        out += ",\"vm_steps\":" + std::to_string(q.vmSteps) + "}";
+    }
+    out += "]}";
+    return out;
+}
@@ -0,0 +1,43 @@
+#ifndef SLOW_QUERY_LOG_H
+#define SLOW_QUERY_LOG_H
+
+#include <sqlite3.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct SlowQuery {
+    int64_t unixTime;
+    double durationMs;
+    std::string sql;         // with bound values substituted
+    int fullScanSteps;       // rows stepped through by full table scans
+    int sorts;               // ORDER BYs that needed a sort
+    int autoIndexRows;       // rows inserted into automatic indexes
+    int vmSteps;             // virtual machine instructions run
+};
+
+// Statements slower than a threshold, kept in a fixed-size ring buffer and
+// served at /debug/slow-queries.
+//
+// attach() installs an SQLITE_TRACE_PROFILE hook on a connection. The hook
+// runs once per finished statement; fast ones only get their
+// sqlite3_stmt_status counters reset, slow ones have their SQL expanded and
+// are copied into the buffer under a lock. The
+// duration is wall time from first step to completion, so a streamed list
+// includes the time spent writing rows between steps.
+class SlowQueryLog {
+public:
+    static const size_t kCapacity = 128;
+
+    // Queries at or above thresholdMs are recorded; negative disables.
+    static void setThresholdMs(double thresholdMs);
+    static double thresholdMs();
+    static void attach(sqlite3* db);
+
+    // Newest first
+    static std::vector<SlowQuery> entries();
+    static uint64_t totalRecorded();
+    static std::string renderJson();
+};
+
+#endif
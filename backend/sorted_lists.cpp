@@ -0,0 +1,121 @@
+#include "sorted_lists.h"
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+
+SortedLists::SortedLists() : loaded(false) {}
+
+bool SortedLists::load(Database& db) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    keys.clear();
+    byCreatedAt.clear();
+    byCookTime.clear();
+    byDifficulty.clear();
+
+    RecipeCursor cursor = db.queryAllRecipes();
+    while (cursor.next()) {
+        const RecipeView& row = cursor.row();
+        insertLocked(row.id, Keys{std::string(row.created_at), row.cook_time, static_cast<int>(row.difficulty)});
+    }
+    bool ok = cursor.ok();
+    loaded.store(ok, std::memory_order_release);
+    if (!ok) {
+        std::cerr << "Failed to load recipes into the sorted lists" << std::endl;
+    }
+    return ok;
+}
+
+size_t SortedLists::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return keys.size();
+}
+
+void SortedLists::insertLocked(int id, Keys entry) {
+    byCreatedAt.emplace(entry.createdAt, id);
+    byCookTime.emplace(entry.cookTime, id);
+    byDifficulty.emplace(entry.difficulty, id);
+    keys[id] = std::move(entry);
+}
+
+void SortedLists::eraseLocked(int id) {
+    auto it = keys.find(id);
+    if (it == keys.end()) {
+        return;
+    }
+    const Keys& entry = it->second;
+    byCreatedAt.erase({entry.createdAt, id});
+    byCookTime.erase({entry.cookTime, id});
+    byDifficulty.erase({entry.difficulty, id});
+    keys.erase(it);
+}
+
+void SortedLists::recipeStored(const Recipe& recipe) {
+    Keys entry{recipe.created_at, recipe.cook_time, static_cast<int>(recipe.difficulty)};
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    eraseLocked(recipe.id);
+    insertLocked(recipe.id, std::move(entry));
+}
+
+void SortedLists::recipeDeleted(const RecipeTombstone& tombstone) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    eraseLocked(tombstone.id);
+}
+
+bool SortedLists::applyImported(Database& db, long long afterSeq, long long throughSeq) {
+    const int kBatchRows = 1000;
+    long long seen = afterSeq;
+    while (seen < throughSeq) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        RecipeCursor cursor = db.querySortKeys(seen, throughSeq, kBatchRows);
+        int rows = 0;
+        while (cursor.next()) {
+            const RecipeView& row = cursor.row();
+            eraseLocked(row.id);
+            insertLocked(row.id, Keys{std::string(row.created_at), row.cook_time, static_cast<int>(row.difficulty)});
+            seen = row.change_seq;
+            ++rows;
+        }
+        if (!cursor.ok()) {
+            std::cerr << "Failed to add imported recipes to the sorted lists" << std::endl;
+            return false;
+        }
+        if (rows < kBatchRows) {
+            break;
+        }
+    }
+    return true;
+}
+
+template <typename Key>
+std::vector<int> SortedLists::collect(const Order<Key>& order, bool ascending, size_t limit) const {
+    std::vector<int> out;
+    out.reserve(limit);
+    auto take = [&](const std::pair<Key, int>& entry) {
+        out.push_back(entry.second);
+        return out.size() < limit;
+    };
+    if (ascending) {
+        for (auto it = order.begin(); it != order.end() && take(*it); ++it) {
+        }
+    } else {
+        for (auto it = order.rbegin(); it != order.rend() && take(*it); ++it) {
+        }
+    }
+    return out;
+}
+
+std::vector<int> SortedLists::sorted(const std::string& sortBy, const std::string& order, int limit) const {
+    bool ascending = order == "asc";
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    size_t count = limit > 0 ? std::min(static_cast<size_t>(limit), keys.size()) : keys.size();
+    if (count == 0) {
+        return std::vector<int>();
+    }
+    if (sortBy == "cook_time") {
+        return collect(byCookTime, ascending, count);
+    }
+    if (sortBy == "difficulty") {
+        return collect(byDifficulty, ascending, count);
+    }
+    return collect(byCreatedAt, ascending, count);
+}
@@ -0,0 +1,70 @@
+#ifndef SORTED_LISTS_H
+#define SORTED_LISTS_H
+
+#include "database.h"
+#include "recipe.h"
+#include <atomic>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// The catalog's list orders held in memory: created_at (also the default
+// list), cook_time and difficulty, each tie-broken by id in the same
+// direction as querySortedRecipes. Only the sort keys and ids are kept;
+// callers fetch the rows for a page with Database::queryRecipesByIds.
+// Loaded once, then kept current as a RecipeObserver: every insert, update
+// or delete moves one entry per order in O(log n). Bulk imports are applied
+// with applyImported() once their rows are numbered.
+class SortedLists : public RecipeObserver {
+private:
+    template <typename Key>
+    using Order = std::set<std::pair<Key, int>>;
+
+    struct Keys {
+        std::string createdAt;
+        int cookTime;
+        int difficulty;
+    };
+
+    mutable std::shared_mutex mutex;
+    std::unordered_map<int, Keys> keys;
+    Order<std::string> byCreatedAt;
+    Order<int> byCookTime;
+    Order<int> byDifficulty;
+    std::atomic<bool> loaded;  // read by handlers without the mutex
+
+    void insertLocked(int id, Keys entry);
+    void eraseLocked(int id);
+
+    template <typename Key>
+    std::vector<int> collect(const Order<Key>& order, bool ascending, size_t limit) const;
+
+public:
+    SortedLists();
+
+    // Reads every row's keys. Call before the server starts and before
+    // adding this as an observer.
+    bool load(Database& db);
+    bool enabled() const { return loaded.load(std::memory_order_acquire); }
+    size_t size() const;
+
+    // Ids ordered like querySortedRecipes(sortBy, order, limit); limit <= 0
+    // returns all of them. A row changed between this call and the fetch
+    // comes back with its new values (or not at all, if deleted).
+    std::vector<int> sorted(const std::string& sortBy, const std::string& order, int limit) const;
+
+    // Adds the keys of rows numbered (afterSeq, throughSeq] (see
+    // Database::sequenceNewRows), a batch at a time. Call without the
+    // database's write lock: each batch is read under this object's lock, so
+    // a concurrent write to one of the rows is applied after it, never
+    // overwritten by an older read.
+    bool applyImported(Database& db, long long afterSeq, long long throughSeq);
+
+    void recipeStored(const Recipe& recipe) override;
+    void recipeDeleted(const RecipeTombstone& tombstone) override;
+};
+
+#endif
@@ -0,0 +1,165 @@
+// Checks for Database's change sequence and what delta sync reads from it,
+// and for SortedLists against the SQL list order, on scratch databases
+// under /tmp.
+//
+//   make check
+//
+// Prints each failed check and exits with 1 if there were any.
+
+#include "database.h"
+#include "sorted_lists.h"
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+
+int failures = 0;
+
+void expect(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        std::printf("FAIL %s\n", what);
+        ++failures;
+    }
+}
+
+Recipe makeRecipe(const std::string &title, int cookTime, Difficulty difficulty)
+{
+    Recipe recipe{};
+    recipe.title = title;
+    recipe.description = "d";
+    recipe.protein = 1;
+    recipe.carbs = 2;
+    recipe.cook_time = cookTime;
+    recipe.difficulty = difficulty;
+    recipe.ingredients = "a";
+    recipe.instructions = "b";
+    return recipe;
+}
+
+void removeDatabase(const std::string &path)
+{
+    for (const char *suffix : {"", "-wal", "-shm"})
+    {
+        unlink((path + suffix).c_str());
+    }
+}
+
+// Delete-all must leave the same tombstones a delete per row would: version
+// plus one, numbered after every change a sync client may already have.
+void checkDeleteAll(const std::string &path)
+{
+    Database db(path);
+    expect(db.initialize(), "initialize");
+    expect(db.addRecipe(makeRecipe("one", 10, Difficulty::Easy)), "add one");
+    expect(db.addRecipe(makeRecipe("two", 20, Difficulty::Hard)), "add two");
+    expect(db.updateRecipe(2, makeRecipe("two again", 25, Difficulty::Hard)), "update two");
+    long long before = db.latestChangeSeq();
+    int versions[] = {0, db.getRecipeById(1).version, db.getRecipeById(2).version};
+
+    expect(db.deleteAllRecipes(), "deleteAllRecipes");
+    expect(db.latestChangeSeq() > before, "delete-all advances the change seq");
+
+    SnapshotReader snapshot(path);
+    std::vector<RecipeTombstone> tombstones;
+    expect(snapshot.tombstonesSince(before, 0, tombstones), "tombstonesSince");
+    expect(tombstones.size() == 2, "a tombstone per deleted row");
+    for (const RecipeTombstone &tombstone : tombstones)
+    {
+        expect(tombstone.id == 1 || tombstone.id == 2, "tombstone id");
+        if (tombstone.id == 1 || tombstone.id == 2)
+        {
+            expect(tombstone.version == versions[tombstone.id] + 1, "tombstone version is the row's plus one");
+        }
+        expect(tombstone.change_seq > before && tombstone.change_seq <= db.latestChangeSeq(),
+               "tombstone seq follows earlier changes");
+    }
+    RecipeCursor changes = snapshot.changesSince(0, 0);
+    expect(!changes.next() && changes.ok(), "no rows left to sync");
+}
+
+std::vector<int> sqlOrder(Database &db, const std::string &sortBy, const std::string &order, int limit)
+{
+    std::vector<int> ids;
+    RecipeCursor cursor = db.querySortedRecipes(sortBy, order, limit);
+    cursor.forEach([&](const RecipeView &row) { ids.push_back(row.id); });
+    expect(cursor.ok(), "querySortedRecipes");
+    return ids;
+}
+
+// Every sortBy/order combination must page exactly like the SQL path,
+// ties (same created_at, cook_time or difficulty) included, after writes
+// and a bulk import have gone through the observer and applyImported.
+void checkSortedOrder(const std::string &path)
+{
+    Database db(path);
+    expect(db.initialize(), "initialize");
+    for (int i = 0; i < 40; ++i)
+    {
+        Recipe recipe = makeRecipe("r" + std::to_string(i), (i * 7) % 5 * 10, static_cast<Difficulty>(i % 3 + 1));
+        recipe.created_at = "2024-01-0" + std::to_string(i % 4 + 1) + " 00:00:00";
+        expect(db.addRecipe(recipe), "add");
+    }
+
+    SortedLists lists;
+    expect(lists.load(db), "load sorted lists");
+    db.addObserver(&lists);
+    expect(db.updateRecipe(5, makeRecipe("r5 again", 20, Difficulty::Easy)), "update");
+    expect(db.deleteRecipe(7), "delete");
+    expect(db.addRecipe(makeRecipe("new", 10, Difficulty::Medium)), "add after load");
+
+    {
+        BulkInserter bulk(path, 100);
+        for (int i = 0; i < 10; ++i)
+        {
+            Recipe recipe = makeRecipe("bulk" + std::to_string(i), i % 2 * 30, Difficulty::Hard);
+            recipe.created_at = "2024-01-02 00:00:00";
+            bulk.insert(recipe);
+        }
+        expect(bulk.finish(), "bulk insert");
+    }
+    ChangeRange numbered;
+    expect(db.sequenceNewRows(&numbered), "sequenceNewRows");
+    expect(lists.applyImported(db, numbered.after, numbered.through), "applyImported");
+    expect(lists.size() == 50, "sorted lists hold every row");
+
+    for (const char *sortBy : {"created_at", "cook_time", "difficulty"})
+    {
+        for (const char *order : {"asc", "desc"})
+        {
+            for (int limit : {1, 13, 1000})
+            {
+                if (lists.sorted(sortBy, order, limit) != sqlOrder(db, sortBy, order, limit))
+                {
+                    std::printf("FAIL sorted lists differ from SQL for sortBy=%s order=%s limit=%d\n", sortBy, order,
+                                limit);
+                    ++failures;
+                }
+            }
+        }
+    }
+}
+
+}
+
+int main()
+{
+    std::string path = "/tmp/recipe_database_test_" + std::to_string(getpid()) + ".db";
+    removeDatabase(path);
+    checkDeleteAll(path);
+    removeDatabase(path);
+    checkSortedOrder(path);
+    removeDatabase(path);
+
+    if (failures > 0)
+    {
+        std::printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,71 @@
+// Checks for the request parsing helpers in recipe_import.h.
+//
+//   make check
+//
+// Prints each failed check and exits with 1 if there were any.
+
+#include "recipe_import.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+int failures = 0;
+
+void expectIds(const std::string &text, bool ok, const std::vector<int> &expected = {})
+{
+    std::vector<int> ids;
+    bool parsed = parseIdList(text, ids);
+    if (parsed != ok || (ok && ids != expected))
+    {
+        std::printf("FAIL parseIdList(\"%s\"): expected %s\n", text.c_str(), ok ? "success" : "rejection");
+        ++failures;
+    }
+}
+
+}
+
+int main()
+{
+    expectIds("1,2,3", true, {1, 2, 3});
+    expectIds(" 7 , 3 ", true, {7, 3});
+    expectIds("[4, 5]", true, {4, 5});
+    expectIds("{\"ids\": [9, 8]}", true, {9, 8});
+    expectIds("", true);
+    expectIds("[]", true);
+
+    // Empty items are rejected wherever they are
+    expectIds("1,,2", false);
+    expectIds("1,2,", false);
+    expectIds(",1", false);
+    expectIds(",", false);
+    expectIds("[1,2,]", false);
+    expectIds("{\"ids\":[1,,2]}", false);
+
+    // Whitespace is trimmed around items but never joins digits
+    expectIds(" [ 1 ,2 ] ", true, {1, 2});
+    expectIds("1 2,3", false);
+    expectIds("[1, 2 3]", false);
+    expectIds("{\"ids\":[1 0]}", false);
+
+    expectIds("1,x", false);
+    expectIds("-1", false);
+    expectIds("1234567890", false);
+
+    std::vector<int> reused = {5, 6};
+    if (!parseIdList("7", reused) || reused != std::vector<int>{7})
+    {
+        std::printf("FAIL parseIdList(\"7\") kept ids from an earlier call\n");
+        ++failures;
+    }
+
+    if (failures > 0)
+    {
+        std::printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}